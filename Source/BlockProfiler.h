@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    BlockProfiler.h
+
+    Optional cost measurement of processBlock. The audio thread times every
+    block with the steady clock and updates counters, a histogram of budget
+    usage (block time / block period) and the worst case. Counters are
+    atomics written only by the audio thread, any other thread can read a
+    snapshot at any time. No locks and no allocation on either side.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+//==============================================================================
+class BlockProfiler
+{
+public:
+	// Budget usage in 2 % bins up to 100 %, the last bin counts everything above
+	static const int HISTOGRAM_BINS = 51;
+	static constexpr double BIN_WIDTH = 0.02;
+
+	// Plain copy of the counters
+	struct Stats
+	{
+		uint64_t blocks = 0;
+		uint64_t samples = 0;
+		uint64_t totalNs = 0;
+		uint64_t worstNs = 0;
+		uint64_t overBudget = 0;
+		double usageSum = 0.0;
+		double worstUsage = 0.0;
+		uint64_t histogram[HISTOGRAM_BINS] = {};
+
+		double getMeanNsPerSample() const { return samples > 0 ? (double)totalNs / (double)samples : 0.0; }
+		double getMeanUsage() const { return blocks > 0 ? usageSum / (double)blocks : 0.0; }
+
+		// Usage below which the given fraction of blocks fall, upper edge of the bin
+		double getUsagePercentile(double fraction) const
+		{
+			const double target = fraction * (double)blocks;
+			uint64_t count = 0;
+
+			for (int bin = 0; bin < HISTOGRAM_BINS; ++bin)
+			{
+				count += histogram[bin];
+
+				if ((double)count >= target)
+					return (bin + 1) * BIN_WIDTH;
+			}
+
+			return worstUsage;
+		}
+
+		// Sum of several profilers, e.g. one per worker
+		void merge(const Stats& other)
+		{
+			blocks += other.blocks;
+			samples += other.samples;
+			totalNs += other.totalNs;
+			worstNs = std::max(worstNs, other.worstNs);
+			overBudget += other.overBudget;
+			usageSum += other.usageSum;
+			worstUsage = std::max(worstUsage, other.worstUsage);
+
+			for (int bin = 0; bin < HISTOGRAM_BINS; ++bin)
+				histogram[bin] += other.histogram[bin];
+		}
+	};
+
+	//==============================================================================
+	// Any thread
+	void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+	bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+	// Blocks taking longer than this fraction of their period count as over budget
+	void setBudgetFraction(double fraction) { m_budgetFraction.store(fraction, std::memory_order_relaxed); }
+	double getBudgetFraction() const { return m_budgetFraction.load(std::memory_order_relaxed); }
+
+	// Counters are cleared by the audio thread on its next block
+	void reset() { m_resetRequested.store(true, std::memory_order_relaxed); }
+
+	Stats getStats() const
+	{
+		Stats stats;
+		stats.blocks = m_blocks.load(std::memory_order_relaxed);
+		stats.samples = m_samples.load(std::memory_order_relaxed);
+		stats.totalNs = m_totalNs.load(std::memory_order_relaxed);
+		stats.worstNs = m_worstNs.load(std::memory_order_relaxed);
+		stats.overBudget = m_overBudget.load(std::memory_order_relaxed);
+		stats.usageSum = m_usageSum.load(std::memory_order_relaxed);
+		stats.worstUsage = m_worstUsage.load(std::memory_order_relaxed);
+
+		for (int bin = 0; bin < HISTOGRAM_BINS; ++bin)
+			stats.histogram[bin] = m_histogram[bin].load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
+	//==============================================================================
+	// Audio thread, 0 when disabled
+	uint64_t begin() const
+	{
+		return isEnabled() ? now() : 0;
+	}
+
+	void end(uint64_t startNs, int samples, double sampleRate)
+	{
+		if (startNs == 0 || samples <= 0 || sampleRate <= 0.0)
+			return;
+
+		const uint64_t elapsedNs = now() - startNs;
+
+		if (m_resetRequested.exchange(false, std::memory_order_relaxed))
+			clear();
+
+		const double usage = (double)elapsedNs * sampleRate / (1.0e9 * samples);
+		const int bin = std::min((int)(usage / BIN_WIDTH), HISTOGRAM_BINS - 1);
+
+		// Single writer, load and store instead of read-modify-write
+		add(m_blocks, 1);
+		add(m_samples, (uint64_t)samples);
+		add(m_totalNs, elapsedNs);
+		add(m_histogram[bin], 1);
+		m_usageSum.store(m_usageSum.load(std::memory_order_relaxed) + usage, std::memory_order_relaxed);
+
+		if (usage > getBudgetFraction())
+			add(m_overBudget, 1);
+
+		if (elapsedNs > m_worstNs.load(std::memory_order_relaxed))
+			m_worstNs.store(elapsedNs, std::memory_order_relaxed);
+
+		if (usage > m_worstUsage.load(std::memory_order_relaxed))
+			m_worstUsage.store(usage, std::memory_order_relaxed);
+	}
+
+private:
+	static uint64_t now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static void add(std::atomic<uint64_t>& counter, uint64_t value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	void clear()
+	{
+		for (auto* counter : { &m_blocks, &m_samples, &m_totalNs, &m_worstNs, &m_overBudget })
+			counter->store(0, std::memory_order_relaxed);
+
+		for (auto& bin : m_histogram)
+			bin.store(0, std::memory_order_relaxed);
+
+		m_usageSum.store(0.0, std::memory_order_relaxed);
+		m_worstUsage.store(0.0, std::memory_order_relaxed);
+	}
+
+	std::atomic<bool> m_enabled{ false };
+	std::atomic<bool> m_resetRequested{ false };
+	std::atomic<double> m_budgetFraction{ 0.5 };
+
+	std::atomic<uint64_t> m_blocks{ 0 };
+	std::atomic<uint64_t> m_samples{ 0 };
+	std::atomic<uint64_t> m_totalNs{ 0 };
+	std::atomic<uint64_t> m_worstNs{ 0 };
+	std::atomic<uint64_t> m_overBudget{ 0 };
+	std::atomic<double> m_usageSum{ 0.0 };
+	std::atomic<double> m_worstUsage{ 0.0 };
+	std::atomic<uint64_t> m_histogram[HISTOGRAM_BINS] = {};
+};
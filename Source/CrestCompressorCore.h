@@ -0,0 +1,1430 @@
+/*
+  ==============================================================================
+
+    CrestCompressorCore.h
+
+    The whole signal path of CrestCompressor without JUCE: crest detector,
+    gain computer, envelope, lookahead, multiband, link and oversampling.
+    Header only, it needs just the DspKernels*.cpp translation units, which
+    are plain C++ too. CrestCompressorAudioProcessor wraps one per sample
+    type, other hosts (audio servers, command line tools) use it directly.
+
+    Processing is in place over planar channel pointers, or over interleaved
+    frames through a chunk sized planar scratch. Parameters are a plain struct
+    in the units of the plugin parameters. Everything is allocated in
+    prepare(), process calls never allocate, lock or throw.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined (__SSE__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define CREST_CORE_SSE_FLUSH 1
+#else
+ #define CREST_CORE_SSE_FLUSH 0
+#endif
+
+#include "Crossover.h"
+#include "DelayLine.h"
+#include "DetectorBank.h"
+#include "DspKernels.h"
+#include "MeterFrame.h"
+#include "Oversampler.h"
+#include "WindowedCrest.h"
+
+//==============================================================================
+// Per sample reference implementations, DetectorBank runs the same recursions
+// for all channels of the core.
+template <typename SampleType>
+class EnvelopeFollower
+{
+public:
+	void init(int sampleRate) { m_SampleRate = sampleRate; m_OutLast = 0; m_Out1Last = 0; }
+
+	void setCoef(SampleType attackTimeMs, SampleType releaseTimeMs)
+	{
+		m_AttackCoef = std::exp(SampleType(-1000) / (attackTimeMs * m_SampleRate));
+		m_ReleaseCoef = std::exp(SampleType(-1000) / (releaseTimeMs * m_SampleRate));
+
+		m_One_Minus_AttackCoef = SampleType(1) - m_AttackCoef;
+		m_One_Minus_ReleaseCoef = SampleType(1) - m_ReleaseCoef;
+	}
+
+	SampleType process(SampleType in)
+	{
+		const SampleType inAbs = std::abs(in);
+		m_Out1Last = std::max(inAbs, m_ReleaseCoef * m_Out1Last + m_One_Minus_ReleaseCoef * inAbs);
+		return m_OutLast = m_AttackCoef * m_OutLast + m_One_Minus_AttackCoef * m_Out1Last;
+	}
+
+protected:
+	int  m_SampleRate = 48000;
+	SampleType m_AttackCoef = 0;
+	SampleType m_One_Minus_AttackCoef = 0;
+	SampleType m_ReleaseCoef = 0;
+	SampleType m_One_Minus_ReleaseCoef = 0;
+
+	SampleType m_OutLast = 0;
+	SampleType m_Out1Last = 0;
+};
+
+//==============================================================================
+template <typename SampleType>
+class CrestFactor
+{
+public:
+	void init(int sampleRate) { m_SampleRate = sampleRate; m_PeakLastSQ = 0; m_RMSLastSQ = 0; }
+	void setCoef(SampleType time) { m_Coef = std::exp(SampleType(-1) / (m_SampleRate * time)); }
+
+	SampleType process(SampleType in)
+	{
+		const SampleType inSQ = in * in;
+		const SampleType inFactor = (SampleType(1) - m_Coef) * inSQ;
+
+		m_PeakLastSQ = std::max(inSQ, m_Coef * m_PeakLastSQ + inFactor);
+		m_RMSLastSQ = m_Coef * m_RMSLastSQ + inFactor;
+
+		// Floored at -200 dB, silence gives 1 instead of 0 / 0
+		const SampleType silenceSQ = SampleType(1.0e-20);
+		return std::sqrt(std::max(m_PeakLastSQ, silenceSQ) / std::max(m_RMSLastSQ, silenceSQ));
+	}
+
+protected:
+	int  m_SampleRate = 48000;
+	SampleType m_Coef = 0;
+
+	SampleType m_PeakLastSQ = 0;
+	SampleType m_RMSLastSQ = 0;
+};
+
+//==============================================================================
+// Values of CrestCompressorCore, in the units of the plugin parameters of the same name
+struct CrestCompressorParameters
+{
+	// Exact uses std::sqrt / ExactMath::exactExp (standard library precision), Fast uses FastMath approximations (< 0.001 dB error, see FastMath.h)
+	enum class Kernel { Exact, Fast };
+
+	// Exponential is the 100 ms one pole peak / RMS of DetectorBank, Window the exact sliding window of WindowedCrest
+	enum class Detector { Exponential, Window };
+
+	// Off runs a detector per channel. Linked runs one for all channels of the bus and applies its gain to each,
+	// from the largest magnitude (Max), the mean square (Power) or the mean (Mid) of the channels.
+	enum class Link { Off, Max, Power, Mid };
+
+	// Multiband mode, Linkwitz-Riley crossovers
+	static const int MAX_BANDS = Crossover<float>::MAX_BANDS;
+
+	// Detector and gain stage at 2x or 4x the sample rate, halfband FIR up and down sampling
+	static const int MAX_OVERSAMPLING = Oversampler<float>::MAX_FACTOR;
+
+	static constexpr float CREST_LIMIT = DspKernels::CREST_LIMIT;
+	static constexpr float ATTENUATION_LIMIT_DB = DspKernels::ATTENUATION_LIMIT_DB;
+	static constexpr float LOOKAHEAD_LIMIT_MS = 10.0f;
+	static constexpr float WINDOW_LIMIT_MS = 500.0f;
+
+	// Input peak below this (-144 dBFS, under the 24 bit LSB) counts as silence
+	static constexpr float SILENCE_LEVEL = 6.0e-8f;
+
+	// Ramp time of threshold, ratio, mix and volume changes in seconds
+	static constexpr double SMOOTHING_TIME = 0.02;
+
+	float smooth = 0.01f;           // Envelope attack in ms, 200 - smooth when band 1 compresses
+	float length = 100.0f;          // Envelope release in ms
+	float mix = 1.0f;               // Processed share, 0 .. 1
+	float volume = 0.0f;            // Output gain in dB
+	float lookahead = 0.0f;         // ms, up to LOOKAHEAD_LIMIT_MS
+	float window = 100.0f;          // Window detector length in ms, up to WINDOW_LIMIT_MS
+
+	Kernel kernel = Kernel::Exact;
+	Detector detector = Detector::Exponential;
+	Link link = Link::Off;
+	int bands = 1;                  // 1 .. MAX_BANDS
+	int controlInterval = 1;        // Samples per gain computer step, 1, 8, 16 or 32, within 0.2 dB of 1 for attacks >= 5 ms
+	int oversampling = 1;           // 1, 2 or 4
+
+	// Per band, only the first is used in single band mode. Ratio is the Attack parameter, negative compresses.
+	float threshold[MAX_BANDS] = { 25.0f, 25.0f, 25.0f, 25.0f };
+	float ratio[MAX_BANDS] = {};
+	float crossover[MAX_BANDS - 1] = { 200.0f, 1000.0f, 5000.0f };
+};
+
+//==============================================================================
+template <typename SampleType>
+class CrestCompressorCore
+{
+public:
+	using Parameters = CrestCompressorParameters;
+	using Link = Parameters::Link;
+
+	static const int MAX_BANDS = Parameters::MAX_BANDS;
+	static const int MAX_OVERSAMPLING = Parameters::MAX_OVERSAMPLING;
+
+	// Samples processed per detector / gain pass, keeps scratch buffers on the stack and in L1
+	static const int CHUNK_SIZE = 256;
+	static_assert(CHUNK_SIZE <= DetectorBank<SampleType>::MAX_BLOCK, "Chunk does not fit detector scratch");
+
+	// Not real time safe. Channels is the most any process call passes, the sidechain has up to as many.
+	void prepare(int channels, double sampleRate, const Parameters& parameters,
+	             DspKernels::InstructionSet instructionSet = DspKernels::getBestInstructionSet())
+	{
+		m_sampleRate = sampleRate;
+		m_parameters = parameters;
+
+		// Widest kernels the CPU runs, chosen once here, processing only calls through the table
+		m_kernels = &DspKernels::getTable<SampleType>(instructionSet);
+
+		// One detector lane per band and channel, sized for the maximum band count
+		m_detector.prepare(channels * MAX_BANDS, (int)(sampleRate));
+		m_detector.setKernels(*m_kernels);
+		m_detector.setCrestCoef(SampleType(0.1));
+
+		// The window detector writes one value per oversampled sample
+		m_gainBuffer.setSize(channels * MAX_BANDS, CHUNK_SIZE * MAX_OVERSAMPLING);
+
+		// Per sample until the first block, last control point gain of every detector lane
+		m_controlInterval = 1;
+		m_detector.setControlInterval(1);
+		m_controlGain.assign((size_t)(channels * MAX_BANDS), SampleType(1));
+		m_gainStages.assign((size_t)(channels * MAX_BANDS), GainStage::Unity);
+		m_keyInput.assign((size_t)channels, nullptr);
+		m_chunkRows.assign((size_t)channels, nullptr);
+
+		m_crossover.prepare(channels, sampleRate);
+		m_crossover.setKernels(*m_kernels);
+		m_keyCrossover.prepare(channels, sampleRate);
+		m_keyCrossover.setKernels(*m_kernels);
+		m_bandBuffer.setSize(channels * MAX_BANDS, CHUNK_SIZE);
+		m_keyBandBuffer.setSize(channels * MAX_BANDS, CHUNK_SIZE);
+
+		// Padding rows between bands stay zero
+		m_linkBuffer.setSize(MAX_BANDS, CHUNK_SIZE);
+
+		// Filter state and oversampled rows for 4x, changing the factor later never reallocates
+		m_detectorOversampler.prepare(channels * MAX_BANDS, CHUNK_SIZE);
+		m_audioOversampler.prepare(channels * MAX_BANDS, CHUNK_SIZE);
+		m_detectorOversampler.setKernels(*m_kernels);
+		m_audioOversampler.setKernels(*m_kernels);
+		m_oversampledBuffer.setSize(channels * MAX_BANDS, CHUNK_SIZE * MAX_OVERSAMPLING);
+		m_oversampledAudio.setSize(2, CHUNK_SIZE * MAX_OVERSAMPLING);
+		m_oversampledGain.assign((size_t)(channels * MAX_BANDS), SampleType(1));
+
+		// Planar copy of interleaved chunks
+		m_planar.setSize(channels, CHUNK_SIZE);
+		m_keyPlanar.setSize(channels, CHUNK_SIZE);
+
+		m_channels = channels;
+		m_bands = 0;
+		updateBands(1, Link::Off);
+
+		// Window history only when the Window detector is selected, see prepareWindow()
+		prepareWindow(parameters);
+
+		// Lookahead storage for the maximum delay, changing lookahead later never reallocates
+		m_delayLine.prepare(channels, (int)std::ceil(Parameters::LOOKAHEAD_LIMIT_MS * 0.001 * sampleRate), CHUNK_SIZE);
+		m_delayLine.setDelay(0);
+
+		// Latency is known before the first block
+		const auto target = getTarget(m_parameters);
+		m_oversampling = 0;
+		updateOversampling(target.oversampling);
+		updateLookahead(target.lookahead);
+
+		// Force envelope coefficients on the first block
+		m_envelopeAttack = -1.0f;
+		m_envelopeRelease = -1.0f;
+
+		m_silentSamples = 0;
+		m_idle = false;
+
+		// Start smoothers at the current values, no ramp after prepare
+		for (int band = 0; band < MAX_BANDS; ++band)
+		{
+			m_thresholdSmoothed[band].reset(sampleRate, Parameters::SMOOTHING_TIME, target.thresholdNormalized[band]);
+			m_attenuationFactorSmoothed[band].reset(sampleRate, Parameters::SMOOTHING_TIME, target.attenuationFactor[band]);
+		}
+
+		m_mixSmoothed.reset(sampleRate, Parameters::SMOOTHING_TIME, target.mix);
+		m_volumeSmoothed.reset(sampleRate, Parameters::SMOOTHING_TIME, target.volume);
+	}
+
+	// Not real time safe, not concurrent with process calls. Window detector history for the detector rows,
+	// the oversampling and the longest window of parameters, none for the exponential detector. Moving Window
+	// later never reallocates. When parameters select the Window detector without room for it, the exponential
+	// detector stands in until this is called, see needsWindowStorage().
+	void prepareWindow(const Parameters& parameters)
+	{
+		const auto target = getTarget(parameters);
+
+		if (target.windowedDetector)
+			m_windowedCrest.prepare(getWindowRows(target), getWindowCapacity(target));
+		else
+			m_windowedCrest.prepare(0, 1);
+
+		m_windowedCrest.setNumChannels(m_detectorChannels * m_bandStride);
+		m_windowed = false;
+	}
+
+	// Any thread, no allocation. True when parameters select the Window detector and prepareWindow() has not
+	// made room for their bands, link and oversampling.
+	bool needsWindowStorage(const Parameters& parameters) const
+	{
+		if (parameters.detector != Parameters::Detector::Window)
+			return false;
+
+		return ! hasWindowStorage(getTarget(parameters));
+	}
+
+	// Values from the next process call on, ramped where the plugin ramps them
+	void setParameters(const Parameters& parameters) { m_parameters = parameters; }
+	const Parameters& getParameters() const { return m_parameters; }
+
+	// Lookahead and oversampling filter delay of the output, changes with the parameters
+	int getLatencySamples() const { return m_latency; }
+
+	double getSampleRate() const { return m_sampleRate; }
+	int getNumChannels() const { return m_channels; }
+
+	// Summary of the last process call
+	const MeterFrame& getMeterFrame() const { return m_meter; }
+
+	// In place over channels[channel][0 .. samples), channels past the prepared count are left alone.
+	// key, when given, is the sidechain that drives the detector, mono keys every channel.
+	void process(SampleType* const* channels, int numChannels, int samples, const SampleType* const* key = nullptr, int keyChannels = 0)
+	{
+		const ScopedFlushDenormals flushDenormals;
+
+		numChannels = std::min(numChannels, m_channels);
+		keyChannels = (key != nullptr) ? std::min(keyChannels, m_channels) : 0;
+
+		// Input peak of the whole block, for the meter and silence detection
+		float peak = 0.0f;
+		float keyPeak = 0.0f;
+
+		for (int channel = 0; channel < numChannels; ++channel)
+			peak = std::max(peak, getPeak(channels[channel], samples));
+
+		for (int channel = 0; channel < keyChannels; ++channel)
+			keyPeak = std::max(keyPeak, getPeak(key[channel], samples));
+
+		beginBlock(samples, peak, keyPeak, keyChannels > 0);
+
+		for (int start = 0; start < samples; start += CHUNK_SIZE)
+		{
+			const int chunkSamples = std::min((int)CHUNK_SIZE, samples - start);
+
+			for (int channel = 0; channel < numChannels; ++channel)
+			{
+				m_chunkRows[(size_t)channel] = channels[channel] + start;
+
+				if (keyChannels > 0)
+					m_keyInput[(size_t)channel] = key[std::min(channel, keyChannels - 1)] + start;
+			}
+
+			processChunk(m_chunkRows.data(), keyChannels > 0 ? m_keyInput.data() : nullptr, numChannels, chunkSamples);
+		}
+
+		endBlock(numChannels, samples);
+	}
+
+	// In place over frames of numChannels interleaved samples, key as in process() with keyChannels per frame
+	void processInterleaved(SampleType* interleaved, int numChannels, int frames, const SampleType* key = nullptr, int keyChannels = 0)
+	{
+		const ScopedFlushDenormals flushDenormals;
+
+		const int stride = numChannels;
+		const int keyStride = keyChannels;
+		numChannels = std::min(numChannels, m_channels);
+		keyChannels = (key != nullptr) ? std::min(keyChannels, m_channels) : 0;
+
+		float peak = 0.0f;
+		float keyPeak = 0.0f;
+
+		if (numChannels == stride)
+			peak = getPeak(interleaved, frames * stride);
+		else
+			for (int channel = 0; channel < numChannels; ++channel)
+				peak = std::max(peak, getPeak(interleaved + channel, frames, stride));
+
+		if (keyChannels == keyStride && keyChannels > 0)
+			keyPeak = getPeak(key, frames * keyStride);
+		else
+			for (int channel = 0; channel < keyChannels; ++channel)
+				keyPeak = std::max(keyPeak, getPeak(key + channel, frames, keyStride));
+
+		beginBlock(frames, peak, keyPeak, keyChannels > 0);
+
+		SampleType* const* planar = m_planar.get();
+		SampleType* const* keyPlanar = m_keyPlanar.get();
+
+		for (int start = 0; start < frames; start += CHUNK_SIZE)
+		{
+			const int chunkSamples = std::min((int)CHUNK_SIZE, frames - start);
+			SampleType* chunk = interleaved + (size_t)start * (size_t)stride;
+
+			for (int channel = 0; channel < numChannels; ++channel)
+				for (int sample = 0; sample < chunkSamples; ++sample)
+					planar[channel][sample] = chunk[sample * stride + channel];
+
+			for (int channel = 0; channel < numChannels; ++channel)
+			{
+				if (keyChannels == 0)
+					continue;
+
+				// A mono key is copied once and shared
+				if (channel < keyChannels)
+				{
+					const SampleType* keyChunk = key + (size_t)start * (size_t)keyStride;
+
+					for (int sample = 0; sample < chunkSamples; ++sample)
+						keyPlanar[channel][sample] = keyChunk[sample * keyStride + channel];
+				}
+
+				m_keyInput[(size_t)channel] = keyPlanar[std::min(channel, keyChannels - 1)];
+			}
+
+			processChunk(planar, keyChannels > 0 ? m_keyInput.data() : nullptr, numChannels, chunkSamples);
+
+			for (int channel = 0; channel < numChannels; ++channel)
+				for (int sample = 0; sample < chunkSamples; ++sample)
+					chunk[sample * stride + channel] = planar[channel][sample];
+		}
+
+		endBlock(numChannels, frames);
+	}
+
+private:
+	//==============================================================================
+	// Parameter values converted to what processing uses
+	struct Target
+	{
+		float attack = 0.0f;
+		float release = 0.0f;
+		float mix = 1.0f;
+		float volume = 1.0f;
+		float lookahead = 0.0f;
+		bool fastKernel = false;
+		bool windowedDetector = false;
+		Link link = Link::Off;
+		float window = 100.0f;
+		int controlInterval = 1;
+		int oversampling = 1;
+
+		// Per band, only the first is used in single band mode
+		int bands = 1;
+		float factor[MAX_BANDS] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		float attenuationFactor[MAX_BANDS] = {};
+		float thresholdNormalized[MAX_BANDS] = {};
+		float crossover[MAX_BANDS - 1] = {};
+	};
+
+	// Gain of a detector lane for one chunk: none, attenuation in dB, or interpolated linear gain
+	enum class GainStage { Unity, Attenuation, Interpolated };
+
+	using GainMode = DspKernels::GainMode;
+	using GainParameters = DspKernels::GainParameters;
+
+	// Rows of equal length in one allocation, addressed like juce::AudioBuffer channels
+	struct RowBuffer
+	{
+		std::vector<SampleType> samples;
+		std::vector<SampleType*> rows;
+
+		void setSize(int count, int length)
+		{
+			samples.assign((size_t)count * (size_t)length, SampleType(0));
+			rows.resize((size_t)count);
+
+			for (int row = 0; row < count; ++row)
+				rows[(size_t)row] = samples.data() + (size_t)row * (size_t)length;
+		}
+
+		SampleType* const* get() { return rows.data(); }
+	};
+
+	// Linear ramp to each new target over a fixed time, as juce::SmoothedValue
+	class LinearSmoother
+	{
+	public:
+		void reset(double sampleRate, double rampSeconds, float value)
+		{
+			m_rampSamples = (int)std::floor(rampSeconds * sampleRate);
+			m_current = m_target = value;
+			m_countdown = 0;
+		}
+
+		void setTargetValue(float value)
+		{
+			if (value == m_target)
+				return;
+
+			if (m_rampSamples <= 0)
+			{
+				m_current = m_target = value;
+				return;
+			}
+
+			m_target = value;
+			m_countdown = m_rampSamples;
+			m_step = (m_target - m_current) / (float)m_countdown;
+		}
+
+		bool isSmoothing() const { return m_countdown > 0; }
+		float getCurrentValue() const { return m_current; }
+
+		float getNextValue()
+		{
+			if (m_countdown <= 0)
+				return m_target;
+
+			--m_countdown;
+			m_current = (m_countdown > 0) ? m_current + m_step : m_target;
+			return m_current;
+		}
+
+		// Value after samples steps
+		float skip(int samples)
+		{
+			if (samples >= m_countdown)
+			{
+				m_countdown = 0;
+				m_current = m_target;
+				return m_target;
+			}
+
+			m_current += m_step * (float)samples;
+			m_countdown -= samples;
+			return m_current;
+		}
+
+	private:
+		float m_current = 0.0f;
+		float m_target = 0.0f;
+		float m_step = 0.0f;
+		int m_countdown = 0;
+		int m_rampSamples = 0;
+	};
+
+	// Flush to zero and denormals are zero while processing, as juce::ScopedNoDenormals. Decaying
+	// detector and envelope state would otherwise go denormal on silence.
+	class ScopedFlushDenormals
+	{
+	public:
+	   #if CREST_CORE_SSE_FLUSH
+		ScopedFlushDenormals() : m_state(_mm_getcsr()) { _mm_setcsr(m_state | 0x8040); }
+		~ScopedFlushDenormals() { _mm_setcsr(m_state); }
+
+	private:
+		unsigned int m_state;
+	   #elif defined (__aarch64__)
+		ScopedFlushDenormals() { asm volatile("mrs %0, fpcr" : "=r"(m_state)); asm volatile("msr fpcr, %0" : : "r"(m_state | (1ull << 24))); }
+		~ScopedFlushDenormals() { asm volatile("msr fpcr, %0" : : "r"(m_state)); }
+
+	private:
+		uint64_t m_state = 0;
+	   #else
+		ScopedFlushDenormals() {}
+	   #endif
+	};
+
+	//==============================================================================
+	static Target getTarget(const Parameters& parameters)
+	{
+		Target target;
+
+		// Envelope times follow the direction of the first band
+		const auto ratio = -1.0f * parameters.ratio[0];
+		target.attack = (ratio > 0) ? 200.0f - parameters.smooth : parameters.smooth;
+		target.release = parameters.length;
+		target.mix = parameters.mix;
+		target.volume = std::pow(10.0f, parameters.volume * 0.05f);
+		target.lookahead = parameters.lookahead;
+		target.fastKernel = parameters.kernel == Parameters::Kernel::Fast;
+		target.bands = std::min(std::max(parameters.bands, 1), (int)MAX_BANDS);
+		target.windowedDetector = parameters.detector == Parameters::Detector::Window;
+		target.link = parameters.link;
+		target.window = parameters.window;
+		target.controlInterval = std::min(std::max(parameters.controlInterval, 1), 32);
+		target.oversampling = (parameters.oversampling >= 4) ? 4 : (parameters.oversampling >= 2) ? 2 : 1;
+
+		for (int band = 0; band < MAX_BANDS; ++band)
+		{
+			const auto bandRatio = -1.0f * parameters.ratio[band];
+			target.factor[band] = (bandRatio > 0.0f) ? -1.0f : 1.0f;
+			target.attenuationFactor[band] = bandRatio * 4.0f;
+			target.thresholdNormalized[band] = parameters.threshold[band] / Parameters::CREST_LIMIT;
+		}
+
+		for (int split = 0; split < MAX_BANDS - 1; ++split)
+			target.crossover[split] = parameters.crossover[split];
+
+		return target;
+	}
+
+	// Window detector rows of a target, one per detector channel and band stride
+	int getWindowRows(const Target& target) const
+	{
+		int bandStride = 1;
+
+		while (bandStride < target.bands)
+			bandStride *= 2;
+
+		return ((target.link == Link::Off) ? m_channels : 1) * bandStride;
+	}
+
+	// Longest window at the target's oversampled rate
+	int getWindowCapacity(const Target& target) const
+	{
+		return (int)std::ceil(Parameters::WINDOW_LIMIT_MS * 0.001 * m_sampleRate * target.oversampling);
+	}
+
+	bool hasWindowStorage(const Target& target) const
+	{
+		return m_windowedCrest.getMaxChannels() >= getWindowRows(target) && m_windowedCrest.getMaxWindow() >= getWindowCapacity(target);
+	}
+
+	// Moves detector lanes and crossovers to a new band count or link mode, no allocation
+	void updateBands(int bands, Link link)
+	{
+		if (bands == m_bands && link == m_link)
+			return;
+
+		if (bands != m_bands)
+		{
+			m_crossover.setNumBands(bands);
+			m_crossover.reset();
+			m_keyCrossover.setNumBands(bands);
+			m_keyCrossover.reset();
+		}
+
+		// Bands of one channel share adjacent lanes, padded to 2 or 4 so they never straddle a SIMD register
+		m_bands = bands;
+		m_bandStride = 1;
+
+		while (m_bandStride < bands)
+			m_bandStride *= 2;
+
+		// Linked, one detector channel stands for the whole bus, its cost no longer grows with the channel count
+		m_link = link;
+		m_detectorChannels = (link == Link::Off) ? m_channels : 1;
+
+		m_detector.setNumChannels(m_detectorChannels * m_bandStride);
+		m_windowedCrest.setNumChannels(m_detectorChannels * m_bandStride);
+		std::fill(m_controlGain.begin(), m_controlGain.end(), SampleType(1));
+
+		// Oversampler rows move with the lanes
+		m_detectorOversampler.reset();
+		m_audioOversampler.reset();
+		std::fill(m_oversampledGain.begin(), m_oversampledGain.end(), SampleType(1));
+	}
+
+	// Delay only moves its read position
+	void updateLookahead(float lookaheadMs)
+	{
+		m_delayLine.setDelay((int)std::lround(lookaheadMs * 0.001 * m_sampleRate));
+		m_latency = m_delayLine.getDelay() + m_audioOversampler.getLatencySamples();
+	}
+
+	// Moves the detector to the oversampled rate, no allocation
+	void updateOversampling(int oversampling)
+	{
+		if (oversampling == m_oversampling)
+			return;
+
+		m_oversampling = oversampling;
+		m_detectorOversampler.setFactor(oversampling);
+		m_audioOversampler.setFactor(oversampling);
+		m_oversampling = m_audioOversampler.getFactor();
+		std::fill(m_oversampledGain.begin(), m_oversampledGain.end(), SampleType(1));
+
+		// Detector and window run at the oversampled rate, control points stay one per interval of base
+		// samples, so the envelope rate does not change. The crest recursion steps once per base sample.
+		// Detectors restart.
+		m_detector.setSampleRate((int)(m_sampleRate * m_oversampling));
+		m_detector.setCrestCoef(SampleType(0.1));
+		m_detector.setStep(m_oversampling);
+		m_detector.setControlInterval(m_controlInterval * m_oversampling);
+		m_windowedCrest.reset();
+		std::fill(m_controlGain.begin(), m_controlGain.end(), SampleType(1));
+
+		m_envelopeAttack = -1.0f;
+		m_latency = m_delayLine.getDelay() + m_audioOversampler.getLatencySamples();
+	}
+
+	// Samples until silent input has left the delay line and detector window and the envelope has settled
+	int getIdleTailSamples(int delaySamples) const
+	{
+		// Ten attack and release time constants leave < 0.001 dB of the attenuation limit
+		const double envelopeTailMs = 10.0 * (m_envelopeAttack + m_envelopeRelease);
+
+		return delaySamples + (int)std::ceil(envelopeTailMs * 0.001 * m_sampleRate);
+	}
+
+	//==============================================================================
+	// Parameters, smoothers and idle state of one block, before its chunks
+	void beginBlock(int samples, float peak, float keyPeak, bool key)
+	{
+		m_target = getTarget(m_parameters);
+		const auto& target = m_target;
+
+		// Gain computer every controlInterval samples, gain is interpolated in between. Detector and
+		// envelope restart, their coefficients are per control step.
+		if (target.controlInterval != m_controlInterval)
+		{
+			m_controlInterval = target.controlInterval;
+			m_detector.setControlInterval(m_controlInterval * m_oversampling);
+			m_windowedCrest.reset();
+			std::fill(m_controlGain.begin(), m_controlGain.end(), SampleType(1));
+
+			m_envelopeAttack = -1.0f;
+		}
+
+		// Peaks between samples reach the detector, the gain is applied at the higher rate
+		updateOversampling(target.oversampling);
+
+		// Envelope coefficients cost two exp() per channel, update only when attack or release moved
+		if (target.attack != m_envelopeAttack || target.release != m_envelopeRelease)
+		{
+			m_envelopeAttack = target.attack;
+			m_envelopeRelease = target.release;
+
+			m_detector.setEnvelopeCoef(m_envelopeAttack, m_envelopeRelease);
+		}
+
+		updateLookahead(target.lookahead);
+		m_lookahead = m_delayLine.getDelay() > 0;
+
+		// Crest detector engine, the one switched to starts from silence. The exponential one stands in
+		// until the window history is prepared.
+		const bool windowed = target.windowedDetector && hasWindowStorage(target);
+
+		if (windowed != m_windowed)
+		{
+			m_windowed = windowed;
+			m_detector.reset();
+			m_windowedCrest.reset();
+			std::fill(m_controlGain.begin(), m_controlGain.end(), SampleType(1));
+		}
+
+		m_windowedCrest.setWindow((int)std::lround(target.window * 0.001 * m_sampleRate * m_oversampling));
+		const int windowSamples = m_windowed ? m_windowedCrest.getWindow() / m_oversampling : 0;
+
+		// Band layout, detector link and crossover frequencies, no allocation
+		updateBands(target.bands, target.link);
+		m_crossover.setFrequencies(target.crossover);
+		m_keyCrossover.setFrequencies(target.crossover);
+
+		// Gain affecting values ramp per sample
+		for (int band = 0; band < MAX_BANDS; ++band)
+		{
+			m_thresholdSmoothed[band].setTargetValue(target.thresholdNormalized[band]);
+			m_attenuationFactorSmoothed[band].setTargetValue(target.attenuationFactor[band]);
+		}
+
+		m_mixSmoothed.setTargetValue(target.mix);
+		m_volumeSmoothed.setTargetValue(target.volume);
+
+		// Meter summary of this block
+		m_meter = MeterFrame();
+		m_meter.peak = peak;
+		m_crestFactorSQMax = 0;
+		m_sumSQ = 0;
+		std::fill(m_attenuationMax, m_attenuationMax + MAX_BANDS, SampleType(0));
+
+		// Idle once silence has passed the delay line and the envelope has settled,
+		// resume from the silence state of the detector on the first non silent block
+		if (peak > Parameters::SILENCE_LEVEL || keyPeak > Parameters::SILENCE_LEVEL)
+		{
+			m_silentSamples = 0;
+
+			if (m_idle)
+			{
+				m_detector.reset();
+				m_windowedCrest.reset();
+				std::fill(m_controlGain.begin(), m_controlGain.end(), SampleType(1));
+				m_crossover.reset();
+				m_keyCrossover.reset();
+				m_detectorOversampler.reset();
+				m_audioOversampler.reset();
+				std::fill(m_oversampledGain.begin(), m_oversampledGain.end(), SampleType(1));
+				m_idle = false;
+			}
+		}
+		else if (! m_idle)
+		{
+			// Counted before this block, the delay line still outputs earlier input
+			m_idle = m_silentSamples >= getIdleTailSamples(m_delayLine.getDelay() + m_audioOversampler.getLatencySamples() + windowSamples);
+			m_silentSamples += samples;
+		}
+
+		// Idle, smoothers keep moving, on silent input the end value can be used for the whole block
+		if (m_idle)
+		{
+			for (int band = 0; band < MAX_BANDS; ++band)
+			{
+				m_thresholdSmoothed[band].skip(samples);
+				m_attenuationFactorSmoothed[band].skip(samples);
+			}
+
+			const float mix = m_mixSmoothed.skip(samples);
+			const float volume = m_volumeSmoothed.skip(samples);
+
+			// Detector gain is 1, see applyUnityGain
+			m_idleGain = (SampleType)(volume * mix) + (SampleType)(volume * (1.0f - mix));
+		}
+
+		// Multiband splits the detector input on its own when it is not the undelayed main input
+		m_key = key;
+		m_keySplit = m_bands > 1 && (key || m_lookahead);
+	}
+
+	void endBlock(int channels, int samples)
+	{
+		if (m_idle)
+		{
+			// Detector output of silence, crest factor 1 and no gain reduction
+			m_meter.crestFactor = std::sqrt(1.0f / Parameters::CREST_LIMIT) * Parameters::CREST_LIMIT;
+			m_meter.gainReductiondB = 0.0f;
+		}
+		else
+		{
+			// Gain reduction of the band attenuating most
+			int meterBand = 0;
+
+			for (int band = 1; band < m_bands; ++band)
+				if (m_attenuationMax[band] > m_attenuationMax[meterBand])
+					meterBand = band;
+
+			// Crest skew is monotonic, so the maximum squared crest gives the maximum skewed crest
+			m_meter.crestFactor = std::sqrt(std::min(std::sqrt((float)m_crestFactorSQMax) / Parameters::CREST_LIMIT, 1.0f)) * Parameters::CREST_LIMIT;
+			m_meter.gainReductiondB = m_target.factor[meterBand] * (float)m_attenuationMax[meterBand];
+		}
+
+		m_meter.rms = (channels > 0 && samples > 0) ? (float)std::sqrt(m_sumSQ / (SampleType)(channels * samples)) : 0.0f;
+		m_meter.samples = samples;
+	}
+
+	//==============================================================================
+	// One chunk of every channel, audio[channel][0 .. chunkSamples). key[channel] is the detector input, or null for the audio.
+	void processChunk(SampleType* const* audio, const SampleType* const* key, int channels, int chunkSamples)
+	{
+		if (m_idle)
+		{
+			processIdleChunk(audio, channels, chunkSamples);
+			return;
+		}
+
+		const auto& target = m_target;
+		const int interval = m_controlInterval;
+		const int oversampling = m_oversampling;
+		const int bands = m_bands;
+		const int bandStride = m_bandStride;
+		const bool linked = m_link != Link::Off;
+
+		// Detector channels, all audio channels or the one linked channel
+		const int detectorChannels = linked ? 1 : channels;
+
+		// Oversampled, the detector input is the audio itself unless keyed, delayed or linked. Its rows then also feed the gain stage.
+		const bool oversampledAudioShared = ! m_key && ! m_lookahead && ! linked;
+
+		// Gain computer outputs of this chunk, one per sample or per control interval
+		const int points = (chunkSamples + interval - 1) / interval;
+
+		// Per sample parameters, only filled while smoothing
+		alignas(32) float thresholdRamp[MAX_BANDS][CHUNK_SIZE];
+		alignas(32) float attenuationFactorRamp[MAX_BANDS][CHUNK_SIZE];
+		alignas(32) float gainScaleRamp[CHUNK_SIZE];
+		alignas(32) float gainOffsetRamp[CHUNK_SIZE];
+
+		bool detectorSmoothing[MAX_BANDS] = {};
+		const bool gainSmoothing = m_mixSmoothed.isSmoothing() || m_volumeSmoothed.isSmoothing();
+
+		for (int band = 0; band < bands; ++band)
+		{
+			detectorSmoothing[band] = m_thresholdSmoothed[band].isSmoothing() || m_attenuationFactorSmoothed[band].isSmoothing();
+
+			if (detectorSmoothing[band])
+			{
+				for (int sample = 0; sample < chunkSamples; ++sample)
+				{
+					thresholdRamp[band][sample] = m_thresholdSmoothed[band].getNextValue();
+					attenuationFactorRamp[band][sample] = m_attenuationFactorSmoothed[band].getNextValue();
+				}
+
+				if (interval > 1)
+				{
+					decimateToControlPoints(thresholdRamp[band], chunkSamples, interval);
+					decimateToControlPoints(attenuationFactorRamp[band], chunkSamples, interval);
+				}
+			}
+		}
+
+		// Gain is folded with mix and volume: out = in * (volume * mix * gain + volume * (1 - mix))
+		if (gainSmoothing)
+		{
+			for (int sample = 0; sample < chunkSamples; ++sample)
+			{
+				const float mix = m_mixSmoothed.getNextValue();
+				const float volume = m_volumeSmoothed.getNextValue();
+
+				gainScaleRamp[sample] = volume * mix;
+				gainOffsetRamp[sample] = volume * (1.0f - mix);
+			}
+		}
+
+		GainParameters gainParameters;
+		GainMode gainMode = GainMode::GainRamp;
+
+		if (gainSmoothing)
+		{
+			gainParameters.scaleRamp = gainScaleRamp;
+			gainParameters.offsetRamp = gainOffsetRamp;
+		}
+		else
+		{
+			const float mix = m_mixSmoothed.getCurrentValue();
+			const float volume = m_volumeSmoothed.getCurrentValue();
+
+			gainParameters.scale = volume * mix;
+			gainParameters.offset = volume * (1.0f - mix);
+
+			if (mix == 1.0f)
+				gainMode = (volume == 1.0f) ? GainMode::Gain : GainMode::GainVolume;
+			else
+				gainMode = GainMode::GainMix;
+		}
+
+		// Kernels of this chunk, picked once per band from the instruction set chosen in prepare
+		const auto& kernels = *m_kernels;
+		const int fast = target.fastKernel ? 1 : 0;
+		DspKernels::GainKernel<SampleType> applyAttenuationKernels[MAX_BANDS] = {};
+
+		for (int band = 0; band < bands; ++band)
+			applyAttenuationKernels[band] = kernels.applyAttenuation[fast][target.factor[band] < 0.0f ? 1 : 0][(int)gainMode];
+
+		const auto applyUnityGainKernel = kernels.applyUnityGain[(int)gainMode];
+		const auto applyGainKernel = kernels.applyGain[(int)gainMode];
+
+		// Per sample gain of every channel and band, reused through all passes
+		SampleType* const* gains = m_gainBuffer.get();
+		SampleType* const* bandRows = m_bandBuffer.get();
+		SampleType* const* keyBandRows = m_keyBandBuffer.get();
+		SampleType* const* oversampledRows = m_oversampledBuffer.get();
+
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			// Input level
+			m_sumSQ += sumOfSquares(audio[channel], chunkSamples);
+		}
+
+		// Crest factor of the undelayed input or sidechain, or of its bands
+		const SampleType* const* crestInput = (key != nullptr) ? key : audio;
+
+		if (bands > 1)
+		{
+			SampleType* const* rows = m_keySplit ? keyBandRows : bandRows;
+			(m_keySplit ? m_keyCrossover : m_crossover).process(crestInput, 0, rows, bandStride, channels, chunkSamples);
+
+			crestInput = rows;
+		}
+
+		// Linked, the channels of every band merge into one detector input
+		if (linked)
+		{
+			SampleType* const* linkRows = m_linkBuffer.get();
+
+			for (int band = 0; band < bands; ++band)
+				linkChannels(m_link, crestInput, band, bandStride, channels, linkRows[band], chunkSamples);
+
+			crestInput = linkRows;
+		}
+
+		// Oversampled, peaks between base rate samples reach the detector. It still gives one value per
+		// interval of base samples, the largest crest factor of all oversampled samples in it.
+		const int crestSamples = chunkSamples * oversampling;
+		const int crestInterval = interval * oversampling;
+
+		if (oversampling > 1)
+		{
+			for (int channel = 0; channel < detectorChannels; ++channel)
+			{
+				for (int band = 0; band < bands; ++band)
+				{
+					const int row = channel * bandStride + band;
+					m_detectorOversampler.upsample(row, crestInput[row], oversampledRows[row], chunkSamples);
+				}
+			}
+
+			crestInput = oversampledRows;
+		}
+
+		// Recursive or over the window, all channels and bands at once. At control rate the
+		// recursion steps once per interval, the window is sampled at the end of each interval.
+		if (m_windowed)
+		{
+			m_windowedCrest.processCrestSQ(crestInput, 0, gains, crestSamples);
+
+			if (crestInterval > 1)
+				for (int row = 0; row < m_windowedCrest.getNumChannels(); ++row)
+					decimateToControlPoints(gains[row], crestSamples, crestInterval);
+		}
+		else if (crestInterval > 1)
+		{
+			m_detector.processCrestSQControl(crestInput, 0, gains, crestSamples);
+		}
+		else
+		{
+			m_detector.processCrestSQ(crestInput, 0, gains, crestSamples);
+		}
+
+		for (int channel = 0; channel < detectorChannels; ++channel)
+		{
+			for (int band = 0; band < bands; ++band)
+			{
+				SampleType* gain = gains[channel * bandStride + band];
+				m_crestFactorSQMax = std::max(m_crestFactorSQMax, getMaximum(gain, points));
+
+				const float threshold = m_thresholdSmoothed[band].getCurrentValue();
+				const float attenuationFactor = m_attenuationFactorSmoothed[band].getCurrentValue();
+
+				//Get gain reduction, positive values. Ratio 0 gives zero whatever the crest factor.
+				if (! detectorSmoothing[band] && attenuationFactor == 0.0f)
+					std::fill(gain, gain + points, SampleType(0));
+				else
+					kernels.attenuation[fast][detectorSmoothing[band] ? 1 : 0](gain, points, threshold, attenuationFactor, thresholdRamp[band], attenuationFactorRamp[band]);
+			}
+		}
+
+		// Smooth, recursive, all channels and bands at once
+		m_detector.processEnvelope(gains, points);
+
+		// Gain is applied to the delayed signal, so it leads the audio by the lookahead time
+		if (m_lookahead)
+		{
+			for (int channel = 0; channel < channels; ++channel)
+				m_delayLine.process(audio[channel], channel, chunkSamples);
+
+			m_delayLine.advance(chunkSamples);
+		}
+
+		// Audio bands, the detector split is reused when it was the same signal
+		if (m_keySplit)
+			m_crossover.process(audio, 0, bandRows, bandStride, channels, chunkSamples);
+
+		// Gain of every detector lane, converted once, a linked lane serves all channels.
+		// Attenuation is never negative, a zero maximum means unity gain for the whole chunk, as below threshold or at ratio 0.
+		// Control points are converted on their own and interpolated from the previous chunk's last one.
+		for (int channel = 0; channel < detectorChannels; ++channel)
+		{
+			for (int band = 0; band < bands; ++band)
+			{
+				const int row = channel * bandStride + band;
+				SampleType* gain = gains[row];
+
+				const SampleType bandAttenuationMax = getMaximum(gain, points);
+				m_attenuationMax[band] = std::max(m_attenuationMax[band], bandAttenuationMax);
+
+				SampleType& controlGain = m_controlGain[(size_t)row];
+				GainStage& stage = m_gainStages[(size_t)row];
+
+				if (interval > 1 && (bandAttenuationMax > 0 || controlGain != SampleType(1)))
+				{
+					kernels.attenuationToGain[fast][target.factor[band] < 0.0f ? 1 : 0](gain, points);
+					controlGain = interpolateControlGain(gain, chunkSamples, interval, controlGain);
+					stage = GainStage::Interpolated;
+				}
+				else if (interval == 1 && bandAttenuationMax > 0)
+				{
+					stage = GainStage::Attenuation;
+				}
+				else
+				{
+					stage = GainStage::Unity;
+				}
+			}
+		}
+
+		// Gain at the oversampled rate, the sum of the bands comes down once per channel
+		if (oversampling > 1)
+		{
+			SampleType* oversampledBand = m_oversampledAudio.get()[0];
+			SampleType* oversampledSum = m_oversampledAudio.get()[1];
+
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				SampleType* chunk = audio[channel];
+				SampleType* oversampled = oversampledBand;
+
+				for (int band = 0; band < bands; ++band)
+				{
+					const int row = (linked ? 0 : channel) * bandStride + band;
+					const int audioRow = channel * bandStride + band;
+					const GainStage stage = m_gainStages[(size_t)row];
+					SampleType& previousGain = m_oversampledGain[(size_t)audioRow];
+
+					if (oversampledAudioShared)
+						oversampled = oversampledRows[audioRow];
+					else
+						m_audioOversampler.upsample(audioRow, (bands == 1) ? chunk : bandRows[audioRow], oversampled, chunkSamples);
+
+					// Gain with volume and mix per base sample, the kernels applied to ones. Unity without mix or volume is skipped.
+					if (! (stage == GainStage::Unity && gainMode == GainMode::Gain && previousGain == SampleType(1)))
+					{
+						alignas(32) SampleType bandGain[CHUNK_SIZE];
+						std::fill(bandGain, bandGain + chunkSamples, SampleType(1));
+
+						switch (stage)
+						{
+							case GainStage::Interpolated: applyGainKernel(bandGain, gains[row], chunkSamples, gainParameters); break;
+							case GainStage::Attenuation:  applyAttenuationKernels[band](bandGain, gains[row], chunkSamples, gainParameters); break;
+							case GainStage::Unity:
+							default:                      applyUnityGainKernel(bandGain, gains[row], chunkSamples, gainParameters); break;
+						}
+
+						previousGain = applyOversampledGain(oversampled, bandGain, chunkSamples, oversampling, previousGain);
+					}
+
+					if (bands > 1)
+					{
+						if (band == 0)
+							std::copy(oversampled, oversampled + crestSamples, oversampledSum);
+						else
+							add(oversampledSum, oversampled, crestSamples);
+					}
+				}
+
+				m_audioOversampler.downsample(channel, (bands == 1) ? oversampled : oversampledSum, chunk, chunkSamples);
+			}
+
+			return;
+		}
+
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			// Channel pointer
+			SampleType* chunk = audio[channel];
+
+			for (int band = 0; band < bands; ++band)
+			{
+				const int row = (linked ? 0 : channel) * bandStride + band;
+				SampleType* gain = gains[row];
+				SampleType* bandAudio = (bands == 1) ? chunk : bandRows[channel * bandStride + band];
+
+				// Convert to gain and apply with volume and mix
+				switch (m_gainStages[(size_t)row])
+				{
+					case GainStage::Interpolated: applyGainKernel(bandAudio, gain, chunkSamples, gainParameters); break;
+					case GainStage::Attenuation:  applyAttenuationKernels[band](bandAudio, gain, chunkSamples, gainParameters); break;
+					case GainStage::Unity:
+					default:                      applyUnityGainKernel(bandAudio, gain, chunkSamples, gainParameters); break;
+				}
+			}
+
+			// Sum of the bands, mix and volume are already applied per band
+			if (bands > 1)
+			{
+				std::copy(bandRows[channel * bandStride], bandRows[channel * bandStride] + chunkSamples, chunk);
+
+				for (int band = 1; band < bands; ++band)
+					add(chunk, bandRows[channel * bandStride + band], chunkSamples);
+			}
+		}
+	}
+
+	// Idle chunk, detector is skipped, only lookahead delay, volume and mix are applied
+	void processIdleChunk(SampleType* const* audio, int channels, int chunkSamples)
+	{
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			SampleType* chunk = audio[channel];
+
+			if (m_lookahead)
+				m_delayLine.process(chunk, channel, chunkSamples);
+
+			if (m_idleGain != SampleType(1))
+				for (int sample = 0; sample < chunkSamples; ++sample)
+					chunk[sample] *= m_idleGain;
+
+			m_sumSQ += sumOfSquares(chunk, chunkSamples);
+		}
+
+		if (m_lookahead)
+			m_delayLine.advance(chunkSamples);
+	}
+
+	//==============================================================================
+	// Block helpers. Detector and gain kernels are DspKernels, compiled per instruction set,
+	// the ones below are light and run in the baseline build.
+
+	// Value at the end of each control interval moved to the front, in place (point <= its sample)
+	template <typename ValueType>
+	static void decimateToControlPoints(ValueType* inOut, int samples, int interval)
+	{
+		for (int point = 0; point * interval < samples; ++point)
+			inOut[point] = inOut[std::min((point + 1) * interval, samples) - 1];
+	}
+
+	// Control point gains -> per sample gain, linear from the previous point to each point at the
+	// end of its interval. Points are read from a copy, the row is overwritten. Returns the last point.
+	static SampleType interpolateControlGain(SampleType* pointsToGain, int samples, int interval, SampleType previous)
+	{
+		alignas(32) SampleType points[CHUNK_SIZE];
+		const int pointCount = (samples + interval - 1) / interval;
+		std::copy(pointsToGain, pointsToGain + pointCount, points);
+
+		for (int point = 0; point < pointCount; ++point)
+		{
+			const int first = point * interval;
+			const int length = std::min(interval, samples - first);
+			const SampleType step = (points[point] - previous) / (SampleType)length;
+
+			for (int sample = 0; sample < length; ++sample)
+				pointsToGain[first + sample] = previous + step * (SampleType)(sample + 1);
+
+			previous = points[point];
+		}
+
+		return previous;
+	}
+
+	// inOut[0 .. samples * factor) *= gain, linear from previous to each base sample's gain, which is reached
+	// on its last oversampled sample, where the oversampled detector produced it. Returns the last gain.
+	static SampleType applyOversampledGain(SampleType* inOut, const SampleType* gain, int samples, int factor, SampleType previous)
+	{
+		return (factor == 4) ? applyOversampledGain<4>(inOut, gain, samples, previous)
+			: applyOversampledGain<2>(inOut, gain, samples, previous);
+	}
+
+	// The factor is a constant, so the phases unroll and the loop vectorizes across samples. The first
+	// sample is peeled, the others ramp from the gain before them in the same row.
+	template <int Factor>
+	static SampleType applyOversampledGain(SampleType* inOut, const SampleType* gain, int samples, SampleType previous)
+	{
+		if (samples <= 0)
+			return previous;
+
+		for (int phase = 0; phase < Factor; ++phase)
+			inOut[phase] *= previous + (gain[0] - previous) * ((SampleType)(phase + 1) / (SampleType)Factor);
+
+		for (int sample = 1; sample < samples; ++sample)
+		{
+			const SampleType from = gain[sample - 1];
+			const SampleType step = gain[sample] - from;
+			SampleType* frame = inOut + sample * Factor;
+
+			for (int phase = 0; phase < Factor; ++phase)
+				frame[phase] *= from + step * ((SampleType)(phase + 1) / (SampleType)Factor);
+		}
+
+		return gain[samples - 1];
+	}
+
+	// Partial sums in independent lanes, so the reduction vectorizes without fast-math
+	static SampleType sumOfSquares(const SampleType* in, int samples)
+	{
+		SampleType sums[8] = {};
+		int sample = 0;
+
+		for (; sample + 8 <= samples; sample += 8)
+			for (int lane = 0; lane < 8; ++lane)
+				sums[lane] += in[sample + lane] * in[sample + lane];
+
+		for (; sample < samples; ++sample)
+			sums[0] += in[sample] * in[sample];
+
+		return ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+	}
+
+	// Largest value, lanes as sumOfSquares
+	static SampleType getMaximum(const SampleType* in, int samples)
+	{
+		if (samples <= 0)
+			return SampleType(0);
+
+		SampleType maxima[8] = { in[0], in[0], in[0], in[0], in[0], in[0], in[0], in[0] };
+		int sample = 0;
+
+		for (; sample + 8 <= samples; sample += 8)
+			for (int lane = 0; lane < 8; ++lane)
+				maxima[lane] = std::max(maxima[lane], in[sample + lane]);
+
+		for (; sample < samples; ++sample)
+			maxima[0] = std::max(maxima[0], in[sample]);
+
+		return std::max(std::max(std::max(maxima[0], maxima[1]), std::max(maxima[2], maxima[3])),
+		                std::max(std::max(maxima[4], maxima[5]), std::max(maxima[6], maxima[7])));
+	}
+
+	// Largest magnitude of samples contiguous values
+	static float getPeak(const SampleType* in, int samples)
+	{
+		SampleType maxima[8] = {};
+		int sample = 0;
+
+		for (; sample + 8 <= samples; sample += 8)
+			for (int lane = 0; lane < 8; ++lane)
+				maxima[lane] = std::max(maxima[lane], std::abs(in[sample + lane]));
+
+		for (; sample < samples; ++sample)
+			maxima[0] = std::max(maxima[0], std::abs(in[sample]));
+
+		return (float)std::max(std::max(std::max(maxima[0], maxima[1]), std::max(maxima[2], maxima[3])),
+		                       std::max(std::max(maxima[4], maxima[5]), std::max(maxima[6], maxima[7])));
+	}
+
+	// Same over every stride-th value
+	static float getPeak(const SampleType* in, int samples, int stride)
+	{
+		SampleType peak = 0;
+
+		for (int sample = 0; sample < samples; ++sample)
+			peak = std::max(peak, std::abs(in[sample * stride]));
+
+		return (float)peak;
+	}
+
+	static void add(SampleType* inOut, const SampleType* in, int samples)
+	{
+		for (int sample = 0; sample < samples; ++sample)
+			inOut[sample] += in[sample];
+	}
+
+	// One band of all channels, rows[channel * stride + band], merged into the single detector input of a linked bus.
+	// Power gives the root mean square, the detector squares it again.
+	static void linkChannels(Link link, const SampleType* const* rows, int band, int stride, int channels, SampleType* out, int samples)
+	{
+		const SampleType scale = SampleType(1) / (SampleType)channels;
+		const SampleType* first = rows[band];
+
+		switch (link)
+		{
+			case Link::Max:
+				for (int sample = 0; sample < samples; ++sample)
+					out[sample] = std::abs(first[sample]);
+
+				for (int channel = 1; channel < channels; ++channel)
+				{
+					const SampleType* in = rows[channel * stride + band];
+
+					for (int sample = 0; sample < samples; ++sample)
+						out[sample] = std::max(out[sample], std::abs(in[sample]));
+				}
+				break;
+
+			case Link::Power:
+				for (int sample = 0; sample < samples; ++sample)
+					out[sample] = first[sample] * first[sample];
+
+				for (int channel = 1; channel < channels; ++channel)
+				{
+					const SampleType* in = rows[channel * stride + band];
+
+					for (int sample = 0; sample < samples; ++sample)
+						out[sample] += in[sample] * in[sample];
+				}
+
+				for (int sample = 0; sample < samples; ++sample)
+					out[sample] = std::sqrt(out[sample] * scale);
+				break;
+
+			case Link::Mid:
+			case Link::Off:
+			default:
+				std::copy(first, first + samples, out);
+
+				for (int channel = 1; channel < channels; ++channel)
+					add(out, rows[channel * stride + band], samples);
+
+				for (int sample = 0; sample < samples; ++sample)
+					out[sample] *= scale;
+				break;
+		}
+	}
+
+	//==============================================================================
+	Parameters m_parameters;
+	Target m_target;
+	double m_sampleRate = 48000.0;
+	int m_channels = 0;
+
+	// Detector and gain kernels of the best instruction set, see DspKernels.h
+	const DspKernels::Table<SampleType>* m_kernels = &DspKernels::getTable<SampleType>(DspKernels::InstructionSet::Scalar);
+
+	DetectorBank<SampleType> m_detector;
+	WindowedCrest<SampleType> m_windowedCrest;
+	bool m_windowed = false;
+
+	// Samples per gain computer step, and the last control point gain per detector lane
+	int m_controlInterval = 1;
+	std::vector<SampleType> m_controlGain;
+	RowBuffer m_gainBuffer;
+
+	// How each detector lane's gain reaches the audio, decided once per chunk
+	std::vector<GainStage> m_gainStages;
+
+	// Linked detector input, one row per band
+	Link m_link = Link::Off;
+	RowBuffer m_linkBuffer;
+
+	DelayLine<SampleType> m_delayLine;
+	bool m_lookahead = false;
+	int m_latency = 0;
+
+	// Chunk pointers of the main input and of the sidechain channel per detector channel, filled per chunk
+	std::vector<SampleType*> m_chunkRows;
+	std::vector<const SampleType*> m_keyInput;
+	bool m_key = false;
+
+	// Interleaved entry, planar copy of one chunk
+	RowBuffer m_planar;
+	RowBuffer m_keyPlanar;
+
+	// Multiband, bands of channel c in rows c * bandStride + band. Audio bands, and
+	// detector bands when the detector input differs from the undelayed main input.
+	Crossover<SampleType> m_crossover;
+	Crossover<SampleType> m_keyCrossover;
+	RowBuffer m_bandBuffer;
+	RowBuffer m_keyBandBuffer;
+	bool m_keySplit = false;
+
+	int m_bands = 0;
+	int m_bandStride = 1;
+
+	// Audio channels, or 1 when linked
+	int m_detectorChannels = 0;
+
+	// Oversampled, the detector input rows go up only, the audio rows go up and each channel's sum
+	// of bands comes down again. Gains are per base sample, interpolated from the last one per audio row.
+	int m_oversampling = 1;
+	Oversampler<SampleType> m_detectorOversampler;
+	Oversampler<SampleType> m_audioOversampler;
+	RowBuffer m_oversampledBuffer;
+	RowBuffer m_oversampledAudio;
+	std::vector<SampleType> m_oversampledGain;
+
+	// Last values the envelope coefficients were computed for
+	float m_envelopeAttack = -1.0f;
+	float m_envelopeRelease = -1.0f;
+
+	LinearSmoother m_thresholdSmoothed[MAX_BANDS];
+	LinearSmoother m_attenuationFactorSmoothed[MAX_BANDS];
+	LinearSmoother m_mixSmoothed;
+	LinearSmoother m_volumeSmoothed;
+
+	// Consecutive silent input samples, idle once past getIdleTailSamples()
+	int m_silentSamples = 0;
+	bool m_idle = false;
+	SampleType m_idleGain = 1;
+
+	// Meter summary of the block in progress and of the last one
+	MeterFrame m_meter;
+	SampleType m_crestFactorSQMax = 0;
+	SampleType m_attenuationMax[MAX_BANDS] = {};
+	SampleType m_sumSQ = 0;
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    Crossover.h
+
+    Linkwitz-Riley 4th order band split into 1 to MAX_BANDS bands. Each split
+    is two cascaded TPT state variable filters giving low and high at once.
+    Lower bands also get the allpass of every split above them, so all bands
+    carry the same phase and their sum is an allpass of the input (flat
+    magnitude). Storage is sized in prepare().
+
+    Channels run in groups of LANES like DetectorBank, every split and
+    allpass of a group advances in one pass per sample. The recursion is a
+    DspKernels kernel, built per instruction set, see setKernels().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "DspKernels.h"
+
+//==============================================================================
+template <typename SampleType>
+class Crossover
+{
+public:
+	static const int MAX_BANDS = DspKernels::CROSSOVER_MAX_BANDS;
+	static const int LANES = DspKernels::DETECTOR_LANES;
+	static const int MAX_BLOCK = 256;
+
+	// Not real time safe
+	void prepare(int channels, double sampleRate)
+	{
+		m_sampleRate = sampleRate;
+		m_groups.assign((size_t)((channels + LANES - 1) / LANES), State());
+		m_frames.assign((size_t)((MAX_BANDS + 1) * MAX_BLOCK * LANES), SampleType(0));
+
+		// Force coefficients on the next setFrequencies()
+		std::fill(m_frequencies, m_frequencies + MAX_BANDS - 1, -1.0);
+	}
+
+	// Kernels of one instruction set, see DspKernels::getTable(). Scalar until set.
+	void setKernels(const DspKernels::Table<SampleType>& kernels) { m_kernels = &kernels; }
+
+	void reset()
+	{
+		std::fill(m_groups.begin(), m_groups.end(), State());
+	}
+
+	void setNumBands(int bands) { m_bands = std::max(1, std::min(bands, (int)MAX_BANDS)); }
+	int getNumBands() const { return m_bands; }
+
+	// MAX_BANDS - 1 split frequencies in Hz, kept ascending and below Nyquist
+	void setFrequencies(const float* frequencies)
+	{
+		double previous = 10.0;
+
+		for (int split = 0; split < MAX_BANDS - 1; ++split)
+		{
+			const double frequency = std::min(std::max((double)frequencies[split], previous), 0.45 * m_sampleRate);
+			previous = frequency;
+
+			if (frequency != m_frequencies[split])
+			{
+				m_frequencies[split] = frequency;
+				m_splits[split] = makeSplit(frequency, m_sampleRate);
+			}
+		}
+	}
+
+	// Splits in[channel][inStart + i] to out[channel * bandStride + band][i], bandStride >= bands
+	void process(const SampleType* const* in, int inStart, SampleType* const* out, int bandStride, int channels, int samples)
+	{
+		channels = std::min(channels, (int)m_groups.size() * LANES);
+
+		if (m_bands == 1)
+		{
+			for (int channel = 0; channel < channels; ++channel)
+				std::copy(in[channel] + inStart, in[channel] + inStart + samples, out[channel * bandStride]);
+
+			return;
+		}
+
+		const auto kernel = m_kernels->crossover[m_bands - 2];
+		SampleType* frames = m_frames.data();
+		SampleType* bandFrames = frames + MAX_BLOCK * LANES;
+
+		for (int done = 0; done < samples; done += MAX_BLOCK)
+		{
+			const int count = std::min((int)MAX_BLOCK, samples - done);
+
+			for (int firstChannel = 0; firstChannel < channels; firstChannel += LANES)
+			{
+				const int lanes = std::min((int)LANES, channels - firstChannel);
+
+				// Planar -> interleaved, lanes past the last channel are zero
+				if (lanes < LANES)
+					std::fill(frames, frames + count * LANES, SampleType(0));
+
+				for (int lane = 0; lane < lanes; ++lane)
+				{
+					const SampleType* channel = in[firstChannel + lane] + inStart + done;
+
+					for (int sample = 0; sample < count; ++sample)
+						frames[sample * LANES + lane] = channel[sample];
+				}
+
+				kernel(frames, bandFrames, count, m_splits, m_groups[(size_t)(firstChannel / LANES)]);
+
+				// Interleaved -> planar per band, padding lanes are dropped
+				for (int lane = 0; lane < lanes; ++lane)
+				{
+					for (int band = 0; band < m_bands; ++band)
+					{
+						const SampleType* source = bandFrames + band * count * LANES + lane;
+						SampleType* channel = out[(firstChannel + lane) * bandStride + band] + done;
+
+						for (int sample = 0; sample < count; ++sample)
+							channel[sample] = source[sample * LANES];
+					}
+				}
+			}
+		}
+	}
+
+private:
+	using State = DspKernels::CrossoverState<SampleType>;
+
+	using Split = DspKernels::CrossoverSplit<SampleType>;
+
+	// Butterworth sections, R2 = sqrt(2)
+	static Split makeSplit(double frequency, double sampleRate)
+	{
+		const double gain = std::tan(3.14159265358979323846 * frequency / sampleRate);
+		const double damping = std::sqrt(2.0);
+
+		Split split;
+		split.g = (SampleType)gain;
+		split.r2 = (SampleType)damping;
+		split.r2PlusG = (SampleType)(damping + gain);
+		split.h = (SampleType)(1.0 / (1.0 + damping * gain + gain * gain));
+		return split;
+	}
+
+	std::vector<State> m_groups;
+	std::vector<SampleType> m_frames;
+	double m_frequencies[MAX_BANDS - 1] = { -1.0, -1.0, -1.0 };
+	Split m_splits[MAX_BANDS - 1];
+	double m_sampleRate = 48000.0;
+	int m_bands = 1;
+
+	const DspKernels::Table<SampleType>* m_kernels = &DspKernels::getTable<SampleType>(DspKernels::InstructionSet::Scalar);
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    DelayLine.h
+
+    Multichannel delay used for lookahead. Storage is allocated in prepare()
+    for the maximum delay, changing the delay afterwards only moves the read
+    position. Block copies in and out of a power of two ring buffer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+//==============================================================================
+template <typename SampleType>
+class DelayLine
+{
+public:
+	// Not real time safe
+	void prepare(int channels, int maxDelaySamples, int maxBlockSamples)
+	{
+		// Must hold the delay and one block written ahead of the read position
+		int size = 1;
+		while (size < maxDelaySamples + maxBlockSamples)
+			size *= 2;
+
+		m_buffer.assign((size_t)channels * (size_t)size, SampleType(0));
+		m_mask = size - 1;
+		m_maxDelay = maxDelaySamples;
+
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(m_buffer.begin(), m_buffer.end(), SampleType(0));
+		m_writePosition = 0;
+	}
+
+	void setDelay(int samples) { m_delay = std::min(std::max(samples, 0), m_maxDelay); }
+	int getDelay() const { return m_delay; }
+
+	// Writes block, up to the prepared maximum, and replaces it by the delayed signal. Call for every channel, then advance().
+	void process(SampleType* inOut, int channel, int samples)
+	{
+		const int size = m_mask + 1;
+		SampleType* ring = m_buffer.data() + (size_t)channel * (size_t)size;
+
+		// Write
+		const int writeStart = m_writePosition;
+		const int write1 = std::min(samples, size - writeStart);
+		std::copy(inOut, inOut + write1, ring + writeStart);
+		std::copy(inOut + write1, inOut + samples, ring);
+
+		// Read delayed
+		const int readStart = (m_writePosition - m_delay) & m_mask;
+		const int read1 = std::min(samples, size - readStart);
+		std::copy(ring + readStart, ring + readStart + read1, inOut);
+		std::copy(ring, ring + samples - read1, inOut + read1);
+	}
+
+	void advance(int samples) { m_writePosition = (m_writePosition + samples) & m_mask; }
+
+private:
+	std::vector<SampleType> m_buffer;
+
+	int m_mask = 0;
+	int m_writePosition = 0;
+	int m_delay = 0;
+	int m_maxDelay = 0;
+};
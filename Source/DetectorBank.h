@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    DetectorBank.h
+
+    CrestFactor and EnvelopeFollower for any number of channels. State is
+    stored as structure of arrays in groups of LANES channels, the recursion
+    runs over all channels of a group at once, so the inner loop maps to one
+    SIMD register (AVX) or two (SSE/NEON) for float, twice as many for double.
+    Storage is sized in prepare(), a "channel" can be any detector input, e.g.
+    one band of one audio channel. Crest factor and envelope can also run at
+    a control rate, once per interval of samples. The recursions themselves
+    are DspKernels, built per instruction set, see setKernels().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "DspKernels.h"
+
+//==============================================================================
+template <typename SampleType>
+class DetectorBank
+{
+public:
+	static const int LANES = DspKernels::DETECTOR_LANES;
+	static const int MAX_BLOCK = 256;
+
+	// Not real time safe
+	void prepare(int channels, int sampleRate)
+	{
+		m_channels = channels;
+		m_sampleRate = sampleRate;
+		m_groups.assign((size_t)getNumGroups(channels), Group());
+	}
+
+	// Channels processed from now on, up to the prepared count. Lanes move, so state is reset.
+	void setNumChannels(int channels)
+	{
+		m_channels = std::min(channels, (int)m_groups.size() * LANES);
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(m_groups.begin(), m_groups.end(), Group());
+	}
+
+	int getNumChannels() const { return m_channels; }
+
+	// Rate of the input, e.g. when it is oversampled. Call setCrestCoef and setEnvelopeCoef again afterwards.
+	void setSampleRate(int sampleRate) { m_sampleRate = sampleRate; }
+
+	// Kernels of one instruction set, see DspKernels::getTable(). Scalar until set.
+	void setKernels(const DspKernels::Table<SampleType>& kernels) { m_kernels = &kernels; }
+
+	// Samples per output of processCrestSQControl. processEnvelope then runs once per interval,
+	// call setEnvelopeCoef again afterwards. State is reset.
+	void setControlInterval(int interval)
+	{
+		m_interval = std::max(1, interval);
+		reset();
+	}
+
+	int getControlInterval() const { return m_interval; }
+
+	// Samples the control rate crest factor recursion advances per step, 1, 2 or 4, e.g. the oversampling
+	// factor, see DspKernels crestSQControl. The control interval must be a multiple of it.
+	void setStep(int step)
+	{
+		m_stepIndex = (step >= 4) ? 2 : (step >= 2) ? 1 : 0;
+	}
+
+	// Same coefficient for all channels, see CrestFactor::setCoef
+	void setCrestCoef(SampleType time)
+	{
+		m_crestCoef = std::exp(SampleType(-1) / (m_sampleRate * time));
+	}
+
+	// See EnvelopeFollower::setCoef, at the control rate
+	void setEnvelopeCoef(SampleType attackTimeMs, SampleType releaseTimeMs)
+	{
+		const SampleType rate = (SampleType)m_sampleRate / (SampleType)m_interval;
+
+		m_attackCoef = std::exp(SampleType(-1000) / (attackTimeMs * rate));
+		m_releaseCoef = std::exp(SampleType(-1000) / (releaseTimeMs * rate));
+	}
+
+	// Squared crest factor (peak^2 / rms^2) of in[channel][inStart + i] to out[channel][i].
+	// Both terms are floored at -200 dB, so silence gives crest factor 1 instead of 0 / 0.
+	void processCrestSQ(const SampleType* const* in, int inStart, SampleType* const* out, int samples)
+	{
+		for (int group = 0; group < getNumGroups(m_channels); ++group)
+		{
+			const int firstChannel = group * LANES;
+			auto& state = m_groups[(size_t)group];
+
+			alignas(64) SampleType interleaved[MAX_BLOCK * LANES];
+			gather(in, inStart, firstChannel, interleaved, samples);
+
+			m_kernels->crestSQ(interleaved, samples, m_crestCoef, state.peakSQ, state.rmsSQ);
+
+			scatter(interleaved, out, 0, firstChannel, samples);
+		}
+	}
+
+	// processCrestSQ at the last sample of each control interval, peak and RMS still follow every
+	// sample. Writes (samples + interval - 1) / interval values to out[channel], the last interval
+	// may be shorter. Longer blocks than MAX_BLOCK pass the scratch in whole intervals, interval <= MAX_BLOCK.
+	void processCrestSQControl(const SampleType* const* in, int inStart, SampleType* const* out, int samples)
+	{
+		const int piece = (MAX_BLOCK / m_interval) * m_interval;
+		const auto kernel = m_kernels->crestSQControl[m_stepIndex];
+
+		for (int group = 0; group < getNumGroups(m_channels); ++group)
+		{
+			const int firstChannel = group * LANES;
+			auto& state = m_groups[(size_t)group];
+
+			alignas(64) SampleType interleaved[MAX_BLOCK * LANES];
+			int point = 0;
+
+			for (int done = 0; done < samples; done += piece)
+			{
+				const int count = std::min(piece, samples - done);
+				gather(in, inStart + done, firstChannel, interleaved, count);
+
+				const int points = kernel(interleaved, count, m_interval, m_crestCoef, state.peakSQ, state.rmsSQ);
+
+				scatter(interleaved, out, point, firstChannel, points);
+				point += points;
+			}
+		}
+	}
+
+	// Attack / release smoothing of inOut[channel][i], in place
+	void processEnvelope(SampleType* const* inOut, int samples)
+	{
+		for (int group = 0; group < getNumGroups(m_channels); ++group)
+		{
+			const int firstChannel = group * LANES;
+			auto& state = m_groups[(size_t)group];
+
+			alignas(64) SampleType interleaved[MAX_BLOCK * LANES];
+			gather(inOut, 0, firstChannel, interleaved, samples);
+
+			m_kernels->envelope(interleaved, samples, m_attackCoef, m_releaseCoef, state.out, state.out1);
+
+			scatter(interleaved, inOut, 0, firstChannel, samples);
+		}
+	}
+
+private:
+	struct Group
+	{
+		alignas(64) SampleType peakSQ[LANES] = {};
+		alignas(64) SampleType rmsSQ[LANES] = {};
+		alignas(64) SampleType out[LANES] = {};
+		alignas(64) SampleType out1[LANES] = {};
+	};
+
+	static int getNumGroups(int channels) { return (channels + LANES - 1) / LANES; }
+
+	// Planar -> interleaved, lanes past the last channel are zero
+	void gather(const SampleType* const* in, int inStart, int firstChannel, SampleType* interleaved, int samples) const
+	{
+		const int lanes = std::min((int)LANES, m_channels - firstChannel);
+
+		if (lanes < LANES)
+			std::fill(interleaved, interleaved + samples * LANES, SampleType(0));
+
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			const SampleType* channel = in[firstChannel + lane] + inStart;
+
+			for (int sample = 0; sample < samples; ++sample)
+				interleaved[sample * LANES + lane] = channel[sample];
+		}
+	}
+
+	// Interleaved -> planar from out[channel][outStart], padding lanes are dropped
+	void scatter(const SampleType* interleaved, SampleType* const* out, int outStart, int firstChannel, int samples) const
+	{
+		const int lanes = std::min((int)LANES, m_channels - firstChannel);
+
+		for (int lane = 0; lane < lanes; ++lane)
+		{
+			SampleType* channel = out[firstChannel + lane] + outStart;
+
+			for (int sample = 0; sample < samples; ++sample)
+				channel[sample] = interleaved[sample * LANES + lane];
+		}
+	}
+
+	std::vector<Group> m_groups;
+	int m_channels = 0;
+	int m_sampleRate = 48000;
+	int m_interval = 1;
+	int m_stepIndex = 0;
+
+	SampleType m_crestCoef = 0;
+	SampleType m_attackCoef = 0;
+	SampleType m_releaseCoef = 0;
+
+	const DspKernels::Table<SampleType>* m_kernels = &DspKernels::getTable<SampleType>(DspKernels::InstructionSet::Scalar);
+};
@@ -0,0 +1,518 @@
+/*
+  ==============================================================================
+
+    DspKernelBodies.h
+
+    Kernel definitions for DspKernels.h. Included once by every DspKernels*.cpp,
+    inside that file's instruction set namespace and target options, so each
+    inclusion is compiled for its own instruction set and the copies never
+    meet at link time. Standard headers and FastMath.h must be included before,
+    outside the namespace, this file includes nothing.
+
+    No state and no dependency between samples except in the detector and
+    crossover recursions, which run over independent lanes, so all loops are
+    left in a shape the compiler can auto-vectorize. Parameters are either a Constant for
+    the whole chunk or a per sample array while a smoother is ramping, both
+    float. Samples are float or double.
+
+  ==============================================================================
+*/
+
+// Keeps the lane loop a loop, so it is vectorized instead of unrolled into scalar chains
+#ifndef DETECTOR_LANE_LOOP
+ #if defined (__clang__)
+  #define DETECTOR_LANE_LOOP _Pragma("clang loop vectorize(enable) unroll(disable)")
+ #elif defined (__GNUC__)
+  #define DETECTOR_LANE_LOOP _Pragma("GCC unroll 1")
+ #else
+  #define DETECTOR_LANE_LOOP
+ #endif
+#endif
+
+// Fully unrolls loops over bands, so the lane loop around them has no nested loop left and vectorizes
+#ifndef BAND_LOOP
+ #if defined (__clang__)
+  #define BAND_LOOP _Pragma("clang loop unroll(full)")
+ #elif defined (__GNUC__)
+  #define BAND_LOOP _Pragma("GCC unroll 4")
+ #else
+  #define BAND_LOOP
+ #endif
+#endif
+
+// Fully unrolls loops over the samples of a detector step, for the same reason
+#ifndef STEP_LOOP
+ #if defined (__clang__)
+  #define STEP_LOOP _Pragma("clang loop unroll(full)")
+ #elif defined (__GNUC__)
+  #define STEP_LOOP _Pragma("GCC unroll 4")
+ #else
+  #define STEP_LOOP
+ #endif
+#endif
+
+//==============================================================================
+// Detector, see CrestFactor::process and EnvelopeFollower::process for the per sample recursions.
+// Frames hold DETECTOR_LANES channels each.
+static const int LANES = DETECTOR_LANES;
+
+// Squared crest factor (peak^2 / rms^2), floored at -200 dB so silence gives 1 instead of 0 / 0
+template <typename SampleType>
+void crestSQ(SampleType* frames, int samples, SampleType coef, SampleType* peakSQState, SampleType* rmsSQState)
+{
+	const SampleType oneMinusCoef = SampleType(1) - coef;
+	const SampleType silenceSQ = SampleType(1.0e-20);
+
+	alignas(64) SampleType peakSQ[LANES];
+	alignas(64) SampleType rmsSQ[LANES];
+	std::copy(peakSQState, peakSQState + LANES, peakSQ);
+	std::copy(rmsSQState, rmsSQState + LANES, rmsSQ);
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		SampleType* frame = frames + sample * LANES;
+
+		DETECTOR_LANE_LOOP
+		for (int lane = 0; lane < LANES; ++lane)
+		{
+			const SampleType inSQ = frame[lane] * frame[lane];
+			const SampleType inFactor = oneMinusCoef * inSQ;
+
+			peakSQ[lane] = std::max(inSQ, coef * peakSQ[lane] + inFactor);
+			rmsSQ[lane] = coef * rmsSQ[lane] + inFactor;
+
+			frame[lane] = std::max(peakSQ[lane], silenceSQ) / std::max(rmsSQ[lane], silenceSQ);
+		}
+	}
+
+	std::copy(peakSQ, peakSQ + LANES, peakSQState);
+	std::copy(rmsSQ, rmsSQ + LANES, rmsSQState);
+}
+
+// Largest crestSQ of each interval. Attenuation rises with the crest factor and the envelope holds
+// its peaks, so the interval maximum is what the per sample envelope would have held at the interval end.
+// Points are written to the front of frames, returns their number.
+// The recursions advance Step samples at once (1, 2 or 4, the oversampling factor), interval a multiple of it.
+// Over a step the peak follower composes to p_k = max(m_k, coef^k * p_0 + a_k) and the RMS to
+// coef^k * r_0 + a_k, with m_k and a_k from the step's inputs only. One multiply-add and max per step
+// then depend on the step before instead of one per sample. Step 1 gives the per sample recursion.
+template <typename SampleType, int Step>
+int crestSQControl(SampleType* frames, int samples, int interval, SampleType coef, SampleType* peakSQState, SampleType* rmsSQState)
+{
+	const SampleType oneMinusCoef = SampleType(1) - coef;
+	const SampleType silenceSQ = SampleType(1.0e-20);
+
+	SampleType coefPower[Step];
+	coefPower[0] = coef;
+
+	for (int k = 1; k < Step; ++k)
+		coefPower[k] = coefPower[k - 1] * coef;
+
+	alignas(64) SampleType peakSQ[LANES];
+	alignas(64) SampleType rmsSQ[LANES];
+	std::copy(peakSQState, peakSQState + LANES, peakSQ);
+	std::copy(rmsSQState, rmsSQState + LANES, rmsSQ);
+
+	int points = 0;
+
+	for (int first = 0; first < samples; first += interval, ++points)
+	{
+		const int length = std::min(interval, samples - first);
+
+		alignas(64) SampleType maxCrestSQ[LANES] = {};
+
+		for (int sample = 0; sample < length; sample += Step)
+		{
+			const SampleType* frame = frames + (first + sample) * LANES;
+
+			DETECTOR_LANE_LOOP
+			for (int lane = 0; lane < LANES; ++lane)
+			{
+				const SampleType peakSQStart = peakSQ[lane];
+				const SampleType rmsSQStart = rmsSQ[lane];
+				SampleType inPeak = 0;
+				SampleType inSum = 0;
+
+				STEP_LOOP
+				for (int k = 0; k < Step; ++k)
+				{
+					const SampleType inSQ = frame[k * LANES + lane] * frame[k * LANES + lane];
+					const SampleType inFactor = oneMinusCoef * inSQ;
+
+					inPeak = std::max(inSQ, coef * inPeak + inFactor);
+					inSum = coef * inSum + inFactor;
+
+					peakSQ[lane] = std::max(inPeak, coefPower[k] * peakSQStart + inSum);
+					rmsSQ[lane] = coefPower[k] * rmsSQStart + inSum;
+
+					maxCrestSQ[lane] = std::max(maxCrestSQ[lane], std::max(peakSQ[lane], silenceSQ) / std::max(rmsSQ[lane], silenceSQ));
+				}
+			}
+		}
+
+		// Written over frames already read, point <= first
+		std::copy(maxCrestSQ, maxCrestSQ + LANES, frames + points * LANES);
+	}
+
+	std::copy(peakSQ, peakSQ + LANES, peakSQState);
+	std::copy(rmsSQ, rmsSQ + LANES, rmsSQState);
+
+	return points;
+}
+
+// Attack / release smoothing
+template <typename SampleType>
+void envelope(SampleType* frames, int samples, SampleType attackCoef, SampleType releaseCoef, SampleType* outState, SampleType* out1State)
+{
+	const SampleType oneMinusAttackCoef = SampleType(1) - attackCoef;
+	const SampleType oneMinusReleaseCoef = SampleType(1) - releaseCoef;
+
+	alignas(64) SampleType out[LANES];
+	alignas(64) SampleType out1[LANES];
+	std::copy(outState, outState + LANES, out);
+	std::copy(out1State, out1State + LANES, out1);
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		SampleType* frame = frames + sample * LANES;
+
+		DETECTOR_LANE_LOOP
+		for (int lane = 0; lane < LANES; ++lane)
+		{
+			const SampleType inAbs = std::abs(frame[lane]);
+			out1[lane] = std::max(inAbs, releaseCoef * out1[lane] + oneMinusReleaseCoef * inAbs);
+			frame[lane] = out[lane] = attackCoef * out[lane] + oneMinusAttackCoef * out1[lane];
+		}
+	}
+
+	std::copy(out, out + LANES, outState);
+	std::copy(out1, out1 + LANES, out1State);
+}
+
+//==============================================================================
+// Crossover, see Crossover.h for the filters. Every split and allpass section of all lanes advances in
+// the same sample step, so the recursions overlap instead of running one after another.
+
+// One TPT state variable filter section, high / band / low
+template <typename SampleType>
+inline void stateVariableSection(const CrossoverSplit<SampleType>& split, SampleType x, SampleType& s1, SampleType& s2,
+                                 SampleType& yH, SampleType& yB, SampleType& yL)
+{
+	yH = (x - split.r2PlusG * s1 - s2) * split.h;
+	yB = split.g * yH + s1;
+	s1 = split.g * yH + yB;
+	yL = split.g * yB + s2;
+	s2 = split.g * yB + yL;
+}
+
+template <typename SampleType, int Bands>
+void crossover(const SampleType* frames, SampleType* bandFrames, int samples, const CrossoverSplit<SampleType>* splitsIn, CrossoverState<SampleType>& stateInOut)
+{
+	// Local copies, the output can not alias them
+	CrossoverSplit<SampleType> splits[Bands - 1];
+	std::copy(splitsIn, splitsIn + Bands - 1, splits);
+	CrossoverState<SampleType> state = stateInOut;
+
+	const int bandStride = samples * LANES;
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		const SampleType* frame = frames + sample * LANES;
+		SampleType* out = bandFrames + sample * LANES;
+
+		DETECTOR_LANE_LOOP
+		for (int lane = 0; lane < LANES; ++lane)
+		{
+			SampleType band[Bands];
+			SampleType remainder = frame[lane];
+
+			// Low to this band, high to the next split. LR4 low is the cascade of two sections,
+			// LR4 high is the first section's allpass minus LR4 low.
+			BAND_LOOP
+			for (int split = 0; split < Bands - 1; ++split)
+			{
+				SampleType yH, yB, yL, yH2, yB2, yL2;
+				stateVariableSection(splits[split], remainder, state.lowHigh[split][0][lane], state.lowHigh[split][1][lane], yH, yB, yL);
+				stateVariableSection(splits[split], yL, state.lowHigh[split][2][lane], state.lowHigh[split][3][lane], yH2, yB2, yL2);
+
+				band[split] = yL2;
+				remainder = yL - splits[split].r2 * yB + yH - yL2;
+			}
+
+			band[Bands - 1] = remainder;
+
+			// Phase of the splits above each lower band
+			BAND_LOOP
+			for (int lower = 0; lower < Bands - 2; ++lower)
+			{
+				BAND_LOOP
+				for (int split = lower + 1; split < Bands - 1; ++split)
+				{
+					SampleType yH, yB, yL;
+					stateVariableSection(splits[split], band[lower], state.allpass[lower][split][0][lane], state.allpass[lower][split][1][lane], yH, yB, yL);
+					band[lower] = yL - splits[split].r2 * yB + yH;
+				}
+			}
+
+			BAND_LOOP
+			for (int index = 0; index < Bands; ++index)
+				out[index * bandStride + lane] = band[index];
+		}
+	}
+
+	stateInOut = state;
+}
+
+//==============================================================================
+// Oversampler halfband, see Oversampler.h. Symmetric taps pair up the newest and oldest sample, one
+// multiply per pair. Four pairs per pass over the block keep the sums in registers, the inner loops vectorize.
+template <typename SampleType>
+void halfBand(const SampleType* line, SampleType* out, int samples, const SampleType* taps, int pairs)
+{
+	const int history = 2 * pairs - 1;
+	int pair = 0;
+
+	std::fill(out, out + samples, SampleType(0));
+
+	for (; pair + 4 <= pairs; pair += 4)
+	{
+		const SampleType c0 = taps[pair], c1 = taps[pair + 1], c2 = taps[pair + 2], c3 = taps[pair + 3];
+		const SampleType* newer = line + history - pair;
+		const SampleType* older = line + pair;
+
+		for (int sample = 0; sample < samples; ++sample)
+			out[sample] += (c0 * (newer[sample] + older[sample]) + c1 * (newer[sample - 1] + older[sample + 1]))
+			             + (c2 * (newer[sample - 2] + older[sample + 2]) + c3 * (newer[sample - 3] + older[sample + 3]));
+	}
+
+	for (; pair < pairs; ++pair)
+	{
+		const SampleType coefficient = taps[pair];
+		const SampleType* newer = line + history - pair;
+		const SampleType* older = line + pair;
+
+		for (int sample = 0; sample < samples; ++sample)
+			out[sample] += coefficient * (newer[sample] + older[sample]);
+	}
+}
+
+//==============================================================================
+// Gain computer
+struct Constant
+{
+	float value;
+	float operator[](int) const { return value; }
+};
+
+// Squared crest factor -> attenuation in dB, positive values
+template <typename SampleType, typename Threshold, typename AttenuationFactor>
+void computeAttenuation(SampleType* crestSQToAttenuation, int samples, Threshold thresholdNormalized, AttenuationFactor attenuationFactor)
+{
+	const SampleType crestLimitInverse = SampleType(1) / CREST_LIMIT;
+	const SampleType attenuationLimit = ATTENUATION_LIMIT_DB;
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		const SampleType crestFactorNormalized = std::min(std::sqrt(crestSQToAttenuation[sample]) * crestLimitInverse, SampleType(1));
+		const SampleType crestSkewed = std::sqrt(crestFactorNormalized);
+
+		const SampleType attenuatedB = std::max(SampleType(0), crestSkewed - (SampleType)thresholdNormalized[sample]) * (SampleType)attenuationFactor[sample];
+		crestSQToAttenuation[sample] = std::min(std::abs(attenuatedB), attenuationLimit);
+	}
+}
+
+// Fast kernel variant, sqrt(sqrt(x)) and the division are replaced by one FastMath::fastPow.
+// FastMath is float only, double samples are converted around it.
+template <typename SampleType, typename Threshold, typename AttenuationFactor>
+void computeAttenuationFast(SampleType* crestSQToAttenuation, int samples, Threshold thresholdNormalized, AttenuationFactor attenuationFactor)
+{
+	// crestSkewed = (crestSQ)^(1/4) / sqrt(CREST_LIMIT), limited to 1
+	const SampleType crestLimitSQ = CREST_LIMIT * CREST_LIMIT;
+	const SampleType crestLimitSqrtInverse = SampleType(1) / std::sqrt((SampleType)CREST_LIMIT);
+	const SampleType attenuationLimit = ATTENUATION_LIMIT_DB;
+
+	// Keep fastPow in its valid range, crest factor is always >= 1. A pass of its own, in one loop
+	// GCC splits the path where the clamp gives a constant and the loop no longer vectorizes.
+	for (int sample = 0; sample < samples; ++sample)
+		crestSQToAttenuation[sample] = std::min(std::max(SampleType(1), crestSQToAttenuation[sample]), crestLimitSQ);
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		const SampleType crestSkewed = (SampleType)FastMath::fastPow((float)crestSQToAttenuation[sample], 0.25f) * crestLimitSqrtInverse;
+
+		const SampleType attenuatedB = std::max(SampleType(0), crestSkewed - (SampleType)thresholdNormalized[sample]) * (SampleType)attenuationFactor[sample];
+		crestSQToAttenuation[sample] = std::min(std::abs(attenuatedB), attenuationLimit);
+	}
+}
+
+template <typename SampleType, bool Fast, bool Ramp>
+void attenuation(SampleType* inOut, int samples, float thresholdNormalized, float attenuationFactor, const float* thresholdRamp, const float* attenuationFactorRamp)
+{
+	if (Ramp && Fast)
+		computeAttenuationFast(inOut, samples, thresholdRamp, attenuationFactorRamp);
+	else if (Ramp)
+		computeAttenuation(inOut, samples, thresholdRamp, attenuationFactorRamp);
+	else if (Fast)
+		computeAttenuationFast(inOut, samples, Constant{ thresholdNormalized }, Constant{ attenuationFactor });
+	else
+		computeAttenuation(inOut, samples, Constant{ thresholdNormalized }, Constant{ attenuationFactor });
+}
+
+// Smoothed attenuation in dB -> linear gain, compression negates the attenuation
+template <typename SampleType, bool Fast, bool Compress>
+inline SampleType attenuationToGain(SampleType attenuation)
+{
+	// decibelsToGain(x) = 10^(x / 20) = e^(x * ln(10) / 20)
+	const SampleType dBToExponent = (Compress ? SampleType(-1) : SampleType(1)) * SampleType(0.05) * SampleType(2.302585092994046);
+
+	if (Fast)
+		return (SampleType)FastMath::fastDecibelsToGain(Compress ? -(float)attenuation : (float)attenuation);
+
+	return ExactMath::exactExp(attenuation * dBToExponent);
+}
+
+template <typename SampleType, bool Fast, bool Compress>
+void convertAttenuationToGain(SampleType* attenuationToGainPoints, int points)
+{
+	for (int point = 0; point < points; ++point)
+		attenuationToGainPoints[point] = attenuationToGain<SampleType, Fast, Compress>(attenuationToGainPoints[point]);
+}
+
+//==============================================================================
+// Gain application. Template arguments are fixed per chunk, the sample loop has no mode branches.
+
+// Attenuation in dB -> gain, applied with mix and volume in the same pass
+template <typename SampleType, bool Fast, bool Compress, GainMode Mode>
+void applyAttenuation(SampleType* inOut, const SampleType* attenuation, int samples, const GainParameters& parameters)
+{
+	const SampleType scale = parameters.scale;
+	const SampleType offset = parameters.offset;
+	const float* scaleRamp = parameters.scaleRamp;
+	const float* offsetRamp = parameters.offsetRamp;
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		const SampleType gain = attenuationToGain<SampleType, Fast, Compress>(attenuation[sample]);
+
+		if (Mode == GainMode::Gain)
+			inOut[sample] *= gain;
+		else if (Mode == GainMode::GainVolume)
+			inOut[sample] *= gain * scale;
+		else if (Mode == GainMode::GainMix)
+			inOut[sample] *= gain * scale + offset;
+		else
+			inOut[sample] *= gain * (SampleType)scaleRamp[sample] + (SampleType)offsetRamp[sample];
+	}
+}
+
+// No attenuation in the chunk (gain is exactly 1), only mix and volume are left
+template <typename SampleType, GainMode Mode>
+void applyUnityGain(SampleType* inOut, const SampleType*, int samples, const GainParameters& parameters)
+{
+	const SampleType scale = parameters.scale;
+	const SampleType scaleAndOffset = parameters.scale + parameters.offset;
+	const float* scaleRamp = parameters.scaleRamp;
+	const float* offsetRamp = parameters.offsetRamp;
+
+	if (Mode == GainMode::Gain)
+		return;
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		if (Mode == GainMode::GainVolume)
+			inOut[sample] *= scale;
+		else if (Mode == GainMode::GainMix)
+			inOut[sample] *= scaleAndOffset;
+		else
+			inOut[sample] *= (SampleType)scaleRamp[sample] + (SampleType)offsetRamp[sample];
+	}
+}
+
+// Linear gain, as interpolated from control points, applied with mix and volume
+template <typename SampleType, GainMode Mode>
+void applyGain(SampleType* inOut, const SampleType* gain, int samples, const GainParameters& parameters)
+{
+	const SampleType scale = parameters.scale;
+	const SampleType offset = parameters.offset;
+	const float* scaleRamp = parameters.scaleRamp;
+	const float* offsetRamp = parameters.offsetRamp;
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		if (Mode == GainMode::Gain)
+			inOut[sample] *= gain[sample];
+		else if (Mode == GainMode::GainVolume)
+			inOut[sample] *= gain[sample] * scale;
+		else if (Mode == GainMode::GainMix)
+			inOut[sample] *= gain[sample] * scale + offset;
+		else
+			inOut[sample] *= gain[sample] * (SampleType)scaleRamp[sample] + (SampleType)offsetRamp[sample];
+	}
+}
+
+//==============================================================================
+template <typename SampleType, bool Fast, bool Compress>
+void fillAttenuationKernels(GainKernel<SampleType>* kernels)
+{
+	kernels[(int)GainMode::Gain]       = &applyAttenuation<SampleType, Fast, Compress, GainMode::Gain>;
+	kernels[(int)GainMode::GainVolume] = &applyAttenuation<SampleType, Fast, Compress, GainMode::GainVolume>;
+	kernels[(int)GainMode::GainMix]    = &applyAttenuation<SampleType, Fast, Compress, GainMode::GainMix>;
+	kernels[(int)GainMode::GainRamp]   = &applyAttenuation<SampleType, Fast, Compress, GainMode::GainRamp>;
+}
+
+template <typename SampleType>
+Table<SampleType> makeTable(InstructionSet instructionSet)
+{
+	Table<SampleType> table;
+	table.instructionSet = instructionSet;
+
+	table.crestSQ = &crestSQ<SampleType>;
+	table.crestSQControl[0] = &crestSQControl<SampleType, 1>;
+	table.crestSQControl[1] = &crestSQControl<SampleType, 2>;
+	table.crestSQControl[2] = &crestSQControl<SampleType, 4>;
+	table.envelope = &envelope<SampleType>;
+
+	table.crossover[0] = &crossover<SampleType, 2>;
+	table.crossover[1] = &crossover<SampleType, 3>;
+	table.crossover[2] = &crossover<SampleType, 4>;
+
+	table.halfBand = &halfBand<SampleType>;
+
+	table.attenuation[0][0] = &attenuation<SampleType, false, false>;
+	table.attenuation[0][1] = &attenuation<SampleType, false, true>;
+	table.attenuation[1][0] = &attenuation<SampleType, true, false>;
+	table.attenuation[1][1] = &attenuation<SampleType, true, true>;
+
+	fillAttenuationKernels<SampleType, false, false>(table.applyAttenuation[0][0]);
+	fillAttenuationKernels<SampleType, false, true>(table.applyAttenuation[0][1]);
+	fillAttenuationKernels<SampleType, true, false>(table.applyAttenuation[1][0]);
+	fillAttenuationKernels<SampleType, true, true>(table.applyAttenuation[1][1]);
+
+	table.applyUnityGain[(int)GainMode::Gain]       = &applyUnityGain<SampleType, GainMode::Gain>;
+	table.applyUnityGain[(int)GainMode::GainVolume] = &applyUnityGain<SampleType, GainMode::GainVolume>;
+	table.applyUnityGain[(int)GainMode::GainMix]    = &applyUnityGain<SampleType, GainMode::GainMix>;
+	table.applyUnityGain[(int)GainMode::GainRamp]   = &applyUnityGain<SampleType, GainMode::GainRamp>;
+
+	table.applyGain[(int)GainMode::Gain]       = &applyGain<SampleType, GainMode::Gain>;
+	table.applyGain[(int)GainMode::GainVolume] = &applyGain<SampleType, GainMode::GainVolume>;
+	table.applyGain[(int)GainMode::GainMix]    = &applyGain<SampleType, GainMode::GainMix>;
+	table.applyGain[(int)GainMode::GainRamp]   = &applyGain<SampleType, GainMode::GainRamp>;
+
+	table.attenuationToGain[0][0] = &convertAttenuationToGain<SampleType, false, false>;
+	table.attenuationToGain[0][1] = &convertAttenuationToGain<SampleType, false, true>;
+	table.attenuationToGain[1][0] = &convertAttenuationToGain<SampleType, true, false>;
+	table.attenuationToGain[1][1] = &convertAttenuationToGain<SampleType, true, true>;
+
+	return table;
+}
+
+// Table of this file's instruction set, INSTRUCTION_SET is declared by the including file
+template <typename SampleType>
+const Table<SampleType>& getTable()
+{
+	static const Table<SampleType> table = makeTable<SampleType>(INSTRUCTION_SET);
+	return table;
+}
+
+template const Table<float>& getTable<float>();
+template const Table<double>& getTable<double>();
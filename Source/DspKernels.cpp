@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    DspKernels.cpp
+
+    Scalar build of DspKernelBodies.h, the baseline every CPU runs, and the
+    runtime choice between the instruction set builds.
+
+  ==============================================================================
+*/
+
+#include "DspKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include "ExactMath.h"
+#include "FastMath.h"
+
+namespace DspKernels
+{
+	namespace Scalar
+	{
+		static const InstructionSet INSTRUCTION_SET = InstructionSet::Scalar;
+
+		#include "DspKernelBodies.h"
+	}
+
+	//==============================================================================
+	static InstructionSet detectInstructionSet()
+	{
+	   #if DSP_KERNELS_MULTI_ISA
+		// Includes the OS check (XGETBV) that AVX and AVX-512 registers are saved on context switches
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq"))
+			return InstructionSet::AVX512;
+
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+			return InstructionSet::AVX2;
+
+		if (__builtin_cpu_supports("sse4.1"))
+			return InstructionSet::SSE41;
+	   #endif
+
+		return InstructionSet::Scalar;
+	}
+
+	InstructionSet getBestInstructionSet()
+	{
+		static const InstructionSet best = detectInstructionSet();
+		return best;
+	}
+
+	const char* getName(InstructionSet instructionSet)
+	{
+		switch (instructionSet)
+		{
+			case InstructionSet::Scalar: return "Scalar";
+			case InstructionSet::SSE41:  return "SSE4.1";
+			case InstructionSet::AVX2:   return "AVX2";
+			case InstructionSet::AVX512: return "AVX-512";
+		}
+
+		return "";
+	}
+
+	template <typename SampleType>
+	const Table<SampleType>& getTable(InstructionSet instructionSet)
+	{
+		// Never hand out code the CPU cannot run
+		instructionSet = std::min(instructionSet, getBestInstructionSet());
+
+		switch (instructionSet)
+		{
+		   #if DSP_KERNELS_MULTI_ISA
+			case InstructionSet::AVX512: return AVX512::getTable<SampleType>();
+			case InstructionSet::AVX2:   return AVX2::getTable<SampleType>();
+			case InstructionSet::SSE41:  return SSE41::getTable<SampleType>();
+		   #endif
+			default:                     return Scalar::getTable<SampleType>();
+		}
+	}
+
+	template const Table<float>& getTable<float>(InstructionSet);
+	template const Table<double>& getTable<double>(InstructionSet);
+}
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    DspKernels.h
+
+    Block kernels of the detector and gain stages, compiled once per x86
+    instruction set (DspKernels*.cpp) and picked at runtime from the CPU's
+    features. Callers get a table of function pointers in prepareToPlay,
+    the audio thread only calls through it, there is no feature test and no
+    branch on the instruction set per block.
+
+    Other compilers and architectures get the Scalar table only, which is the
+    baseline of the build (SSE2 on x86-64, NEON on arm64).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Instruction set variants need per function target options
+#if (defined (__GNUC__) || defined (__clang__)) && (defined (__x86_64__) || defined (__i386__))
+ #define DSP_KERNELS_MULTI_ISA 1
+#else
+ #define DSP_KERNELS_MULTI_ISA 0
+#endif
+
+namespace DspKernels
+{
+	// Ordered, every set includes the ones before it
+	enum class InstructionSet { Scalar, SSE41, AVX2, AVX512 };
+
+	// Channels interleaved per DetectorBank group, one AVX register of float
+	static const int DETECTOR_LANES = 8;
+
+	// Control rate crest factor recursion advances 1, 2 or 4 samples per step, see DetectorBank::setStep
+	static const int DETECTOR_STEPS = 3;
+
+	// Crest factor and attenuation limits of the gain computer, see CrestCompressorAudioProcessor
+	static constexpr float CREST_LIMIT = 50.0f;
+	static constexpr float ATTENUATION_LIMIT_DB = 18.0f;
+
+	// How mix and volume enter the output, picked per chunk from the smoothed values
+	enum class GainMode
+	{
+		Gain,        // Mix 1, volume 0 dB: out = in * gain
+		GainVolume,  // Mix 1: out = in * gain * volume
+		GainMix,     // out = in * (gain * scale + offset)
+		GainRamp     // Mix or volume smoothing, scale and offset per sample
+	};
+
+	static const int GAIN_MODES = 4;
+
+	// Crossover band split, see Crossover.h. Coefficients of one split's TPT state variable filters.
+	static const int CROSSOVER_MAX_BANDS = 4;
+
+	template <typename SampleType>
+	struct CrossoverSplit
+	{
+		SampleType g = 0;
+		SampleType h = 0;
+		SampleType r2 = 0;
+		SampleType r2PlusG = 0;
+	};
+
+	// Filter state of DETECTOR_LANES channels, two sections per split, then the allpasses of each lower band
+	template <typename SampleType>
+	struct CrossoverState
+	{
+		SampleType lowHigh[CROSSOVER_MAX_BANDS - 1][4][DETECTOR_LANES] = {};
+		SampleType allpass[CROSSOVER_MAX_BANDS - 2][CROSSOVER_MAX_BANDS - 1][2][DETECTOR_LANES] = {};
+	};
+
+	// Mix and volume folded to scale and offset: out = in * (volume * mix * gain + volume * (1 - mix))
+	struct GainParameters
+	{
+		float scale = 1.0f;
+		float offset = 0.0f;
+		const float* scaleRamp = nullptr;
+		const float* offsetRamp = nullptr;
+	};
+
+	// inOut *= gain from the second argument (attenuation in dB, or linear gain), with mix and volume
+	template <typename SampleType>
+	using GainKernel = void (*)(SampleType* inOut, const SampleType* gain, int samples, const GainParameters& parameters);
+
+	// Squared crest factor -> attenuation in dB, in place. The ramps are read only by the ramp variant.
+	template <typename SampleType>
+	using AttenuationKernel = void (*)(SampleType* inOut, int samples, float thresholdNormalized, float attenuationFactor,
+	                                   const float* thresholdRamp, const float* attenuationFactorRamp);
+
+	template <typename SampleType>
+	struct Table
+	{
+		InstructionSet instructionSet = InstructionSet::Scalar;
+
+		// DetectorBank recursions over DETECTOR_LANES interleaved channels, in place, state is read and written back.
+		// crestSQControl is per [step], see DetectorBank::setStep.
+		void (*crestSQ)(SampleType* frames, int samples, SampleType coef, SampleType* peakSQ, SampleType* rmsSQ) = nullptr;
+		int (*crestSQControl[DETECTOR_STEPS])(SampleType* frames, int samples, int interval, SampleType coef, SampleType* peakSQ, SampleType* rmsSQ) = {};
+		void (*envelope)(SampleType* frames, int samples, SampleType attackCoef, SampleType releaseCoef, SampleType* out, SampleType* out1) = nullptr;
+
+		// [bands - 2], band split of DETECTOR_LANES interleaved channels, band b to bandFrames + b * samples * DETECTOR_LANES
+		void (*crossover[CROSSOVER_MAX_BANDS - 1])(const SampleType* frames, SampleType* bandFrames, int samples,
+		                                           const CrossoverSplit<SampleType>* splits, CrossoverState<SampleType>& state) = {};
+
+		// Symmetric FIR branch of an Oversampler halfband stage, taps[0 .. pairs) are the first half of
+		// 2 * pairs taps: out[i] = sum of taps[j] * line[2 * pairs - 1 + i - j] over all of them
+		void (*halfBand)(const SampleType* line, SampleType* out, int samples, const SampleType* taps, int pairs) = nullptr;
+
+		// [fast][ramp]
+		AttenuationKernel<SampleType> attenuation[2][2] = {};
+
+		// [fast][compress][GainMode], attenuation in dB -> gain applied to the audio
+		GainKernel<SampleType> applyAttenuation[2][2][GAIN_MODES] = {};
+
+		// [GainMode], no attenuation, only mix and volume
+		GainKernel<SampleType> applyUnityGain[GAIN_MODES] = {};
+
+		// [GainMode], linear gain, as interpolated from control points
+		GainKernel<SampleType> applyGain[GAIN_MODES] = {};
+
+		// [fast][compress], control point attenuation in dB -> linear gain, in place
+		void (*attenuationToGain[2][2])(SampleType* inOut, int points) = {};
+	};
+
+	// Best set the CPU and OS support, detected once
+	InstructionSet getBestInstructionSet();
+
+	const char* getName(InstructionSet instructionSet);
+
+	// Kernels of instructionSet, limited to what the CPU supports. Float and double.
+	template <typename SampleType>
+	const Table<SampleType>& getTable(InstructionSet instructionSet);
+
+	// Per instruction set tables, defined in DspKernels*.cpp. Only call them through getTable.
+	namespace Scalar { template <typename SampleType> const Table<SampleType>& getTable(); }
+	namespace SSE41  { template <typename SampleType> const Table<SampleType>& getTable(); }
+	namespace AVX2   { template <typename SampleType> const Table<SampleType>& getTable(); }
+	namespace AVX512 { template <typename SampleType> const Table<SampleType>& getTable(); }
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    DspKernelsAVX2.cpp
+
+    AVX2 and FMA build of DspKernelBodies.h, Haswell / Zen and later.
+
+  ==============================================================================
+*/
+
+#include "DspKernels.h"
+
+#if DSP_KERNELS_MULTI_ISA
+
+#include <algorithm>
+#include <cmath>
+#include "ExactMath.h"
+#include "FastMath.h"
+
+// Everything defined below is compiled for AVX2, dispatch only calls it when the CPU has it
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+ #pragma GCC push_options
+ #pragma GCC target ("avx2,fma")
+#endif
+
+namespace DspKernels
+{
+	namespace AVX2
+	{
+		static const InstructionSet INSTRUCTION_SET = InstructionSet::AVX2;
+
+		#include "DspKernelBodies.h"
+	}
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#else
+ #pragma GCC pop_options
+#endif
+
+#endif
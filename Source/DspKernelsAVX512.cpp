@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    DspKernelsAVX512.cpp
+
+    AVX-512 (F, VL, BW, DQ) build of DspKernelBodies.h, Skylake-SP / Zen 4 and later.
+
+  ==============================================================================
+*/
+
+#include "DspKernels.h"
+
+#if DSP_KERNELS_MULTI_ISA
+
+#include <algorithm>
+#include <cmath>
+#include "ExactMath.h"
+#include "FastMath.h"
+
+// Everything defined below is compiled for AVX512, dispatch only calls it when the CPU has it
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma"))), apply_to = function)
+#else
+ #pragma GCC push_options
+ #pragma GCC target ("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma")
+#endif
+
+namespace DspKernels
+{
+	namespace AVX512
+	{
+		static const InstructionSet INSTRUCTION_SET = InstructionSet::AVX512;
+
+		#include "DspKernelBodies.h"
+	}
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#else
+ #pragma GCC pop_options
+#endif
+
+#endif
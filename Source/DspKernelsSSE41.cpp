@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    DspKernelsSSE41.cpp
+
+    SSE4.1 build of DspKernelBodies.h, Penryn / Bulldozer and later.
+
+  ==============================================================================
+*/
+
+#include "DspKernels.h"
+
+#if DSP_KERNELS_MULTI_ISA
+
+#include <algorithm>
+#include <cmath>
+#include "ExactMath.h"
+#include "FastMath.h"
+
+// Everything defined below is compiled for SSE41, dispatch only calls it when the CPU has it
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#else
+ #pragma GCC push_options
+ #pragma GCC target ("sse4.1")
+#endif
+
+namespace DspKernels
+{
+	namespace SSE41
+	{
+		static const InstructionSet INSTRUCTION_SET = InstructionSet::SSE41;
+
+		#include "DspKernelBodies.h"
+	}
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#else
+ #pragma GCC pop_options
+#endif
+
+#endif
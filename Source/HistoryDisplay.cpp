@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    HistoryDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "HistoryDisplay.h"
+#include "PluginProcessor.h"
+
+//==============================================================================
+HistoryDisplay::HistoryDisplay()
+	: m_history(HISTORY_COLUMNS)
+{
+	m_background = juce::Colour::fromHSV(0.1f, 0.5f, 0.3f, 1.0f);
+	m_levelColour = juce::Colour::fromHSV(0.1f, 0.3f, 0.5f, 1.0f);
+	m_crestColour = juce::Colour::fromHSV(0.15f, 0.8f, 1.0f, 1.0f);
+	m_gainReductionColour = juce::Colour::fromHSV(0.0f, 0.7f, 0.8f, 1.0f);
+	m_gridColour = juce::Colour::fromHSV(0.1f, 0.5f, 0.4f, 1.0f);
+
+	// Every pixel is drawn from the image, nothing behind needs repainting
+	setOpaque(true);
+}
+
+//==============================================================================
+void HistoryDisplay::addFrame(const MeterFrame& frame, double sampleRate)
+{
+	m_current.peak = std::max(m_current.peak, frame.peak);
+	m_current.crestFactor = std::max(m_current.crestFactor, frame.crestFactor);
+
+	if (std::abs(frame.gainReductiondB) > std::abs(m_current.gainReductiondB))
+		m_current.gainReductiondB = frame.gainReductiondB;
+
+	m_currentSamples += frame.samples;
+
+	// Long blocks complete several columns with the same values
+	const double columnSamples = std::max(1.0, sampleRate * COLUMN_MS * 0.001);
+
+	if (m_currentSamples < columnSamples)
+		return;
+
+	while (m_currentSamples >= columnSamples)
+	{
+		pushColumn(m_current);
+		m_currentSamples -= columnSamples;
+	}
+
+	// Rest of this frame starts the next column
+	m_current = {};
+
+	if (m_currentSamples > 0.0)
+	{
+		m_current.peak = frame.peak;
+		m_current.crestFactor = frame.crestFactor;
+		m_current.gainReductiondB = frame.gainReductiondB;
+	}
+}
+
+void HistoryDisplay::update()
+{
+	if (m_newColumns == 0 || ! m_image.isValid())
+		return;
+
+	const int width = m_image.getWidth();
+	const int columns = std::min(m_newColumns, width);
+	m_newColumns = 0;
+
+	// Shift the cached image left and draw only the new columns at the right edge
+	m_image.moveImageSection(0, 0, columns, 0, width - columns, m_image.getHeight());
+
+	juce::Graphics g(m_image);
+
+	for (int i = 0; i < columns; ++i)
+		drawColumn(g, width - columns + i, columns - 1 - i);
+
+	repaint();
+}
+
+//==============================================================================
+void HistoryDisplay::paint(juce::Graphics& g)
+{
+	if (m_image.isValid())
+		g.drawImageAt(m_image, 0, 0);
+	else
+		g.fillAll(m_background);
+}
+
+void HistoryDisplay::resized()
+{
+	redraw();
+}
+
+//==============================================================================
+const HistoryDisplay::Column& HistoryDisplay::getColumn(int age) const
+{
+	return m_history[(size_t)((m_historyEnd - 1 - age + HISTORY_COLUMNS) % HISTORY_COLUMNS)];
+}
+
+void HistoryDisplay::pushColumn(const Column& column)
+{
+	m_history[(size_t)m_historyEnd] = column;
+	m_historyEnd = (m_historyEnd + 1) % HISTORY_COLUMNS;
+	m_historyCount = std::min(m_historyCount + 1, HISTORY_COLUMNS);
+	m_newColumns = std::min(m_newColumns + 1, HISTORY_COLUMNS);
+}
+
+// Level from the bottom, gain reduction from the top, crest factor as a line joined to the previous column
+void HistoryDisplay::drawColumn(juce::Graphics& g, int x, int age) const
+{
+	const int height = m_image.getHeight();
+
+	g.setColour(m_background);
+	g.fillRect(x, 0, 1, height);
+
+	if (age >= m_historyCount)
+		return;
+
+	const Column& column = getColumn(age);
+
+	const float levelDB = juce::Decibels::gainToDecibels(column.peak, -(float)LEVEL_RANGE_DB);
+	const int levelY = (int)(height * -levelDB / LEVEL_RANGE_DB);
+	g.setColour(m_levelColour);
+	g.fillRect(x, levelY, 1, height - levelY);
+
+	const float gainReduction = std::min(std::abs(column.gainReductiondB) / CrestCompressorAudioProcessor::ATTENUATION_LIMIT_DB, 1.0f);
+	g.setColour(m_gainReductionColour);
+	g.fillRect(x, 0, 1, (int)(height * gainReduction));
+
+	g.setColour(m_gridColour);
+	for (int line = 1; line < 4; ++line)
+		g.fillRect(x, line * height / 4, 1, 1);
+
+	auto crestToY = [height](float crestFactor)
+	{
+		return (int)((height - 1) * (1.0f - std::min(crestFactor / CrestCompressorAudioProcessor::CREST_LIMIT, 1.0f)));
+	};
+
+	const int crestY = crestToY(column.crestFactor);
+	const int previousY = (age + 1 < m_historyCount) ? crestToY(getColumn(age + 1).crestFactor) : crestY;
+	g.setColour(m_crestColour);
+	g.fillRect(x, std::min(crestY, previousY), 1, std::abs(crestY - previousY) + 1);
+}
+
+// Whole image from the stored columns, only after a resize
+void HistoryDisplay::redraw()
+{
+	m_newColumns = 0;
+
+	if (getWidth() <= 0 || getHeight() <= 0)
+	{
+		m_image = juce::Image();
+		return;
+	}
+
+	m_image = juce::Image(juce::Image::RGB, getWidth(), getHeight(), true);
+	juce::Graphics g(m_image);
+
+	for (int x = 0; x < getWidth(); ++x)
+		drawColumn(g, x, getWidth() - 1 - x);
+}
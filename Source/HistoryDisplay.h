@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    HistoryDisplay.h
+
+    Scrolling history of input level, crest factor and gain reduction, one
+    pixel column per COLUMN_MS. Meter frames are aggregated into columns,
+    new columns are drawn into a cached image that is shifted left, so a
+    tick only draws the new columns and repaints this component's bounds.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Meter.h"
+
+//==============================================================================
+class HistoryDisplay : public juce::Component
+{
+public:
+	static const int COLUMN_MS = 20;
+	static const int LEVEL_RANGE_DB = 60;
+
+	HistoryDisplay();
+
+	// GUI thread. Frames are collected, update() draws the columns they completed.
+	void addFrame(const MeterFrame& frame, double sampleRate);
+	void update();
+
+	void paint(juce::Graphics&) override;
+	void resized() override;
+
+private:
+	struct Column
+	{
+		float peak = 0.0f;
+		float crestFactor = 0.0f;
+		float gainReductiondB = 0.0f;
+	};
+
+	// Column age 0 is the newest
+	const Column& getColumn(int age) const;
+	void pushColumn(const Column& column);
+
+	void drawColumn(juce::Graphics& g, int x, int age) const;
+	void redraw();
+
+	// Ring of the newest columns, wider than the display, for redrawing after a resize
+	static const int HISTORY_COLUMNS = 4096;
+	std::vector<Column> m_history;
+	int m_historyEnd = 0;
+	int m_historyCount = 0;
+
+	// Frames of the column being collected
+	Column m_current;
+	double m_currentSamples = 0.0;
+
+	int m_newColumns = 0;
+	juce::Image m_image;
+
+	juce::Colour m_background;
+	juce::Colour m_levelColour;
+	juce::Colour m_crestColour;
+	juce::Colour m_gainReductionColour;
+	juce::Colour m_gridColour;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HistoryDisplay)
+};
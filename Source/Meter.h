@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    Meter.h
+
+    Per block meter summaries, passed from the audio thread to the editor or
+    any other consumer through a wait-free single producer / single consumer
+    FIFO. No locks and no allocation on either side.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MeterFrame.h"
+
+//==============================================================================
+class MeterFifo
+{
+public:
+	static const int CAPACITY = 512;
+
+	// Audio thread. Frame is dropped when the consumer falls behind.
+	bool push(const MeterFrame& frame)
+	{
+		if (m_fifo.getFreeSpace() < 1)
+			return false;
+
+		int start1, size1, start2, size2;
+		m_fifo.prepareToWrite(1, start1, size1, start2, size2);
+		m_frames[size1 > 0 ? start1 : start2] = frame;
+		m_fifo.finishedWrite(1);
+
+		return true;
+	}
+
+	// Single consumer thread. Returns number of frames copied to destination.
+	int pop(MeterFrame* destination, int maxFrames)
+	{
+		int start1, size1, start2, size2;
+		m_fifo.prepareToRead(maxFrames, start1, size1, start2, size2);
+
+		std::copy(m_frames + start1, m_frames + start1 + size1, destination);
+		std::copy(m_frames + start2, m_frames + start2 + size2, destination + size1);
+
+		m_fifo.finishedRead(size1 + size2);
+		return size1 + size2;
+	}
+
+	// Drains the FIFO into one frame: maxima of crest, gain reduction and peak, power average of RMS
+	bool popSummary(MeterFrame& summary)
+	{
+		return popSummary(summary, [](const MeterFrame&) {});
+	}
+
+	// Same, every drained frame is also passed to onFrame, e.g. for a history display
+	template <typename Callback>
+	bool popSummary(MeterFrame& summary, Callback&& onFrame)
+	{
+		MeterFrame frames[64];
+		double sumSQ = 0.0;
+		int frameCount = 0;
+
+		summary = {};
+
+		for (int count = pop(frames, 64); count > 0; count = pop(frames, 64))
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				const auto& frame = frames[i];
+				onFrame(frame);
+
+				summary.crestFactor = std::max(summary.crestFactor, frame.crestFactor);
+				summary.peak = std::max(summary.peak, frame.peak);
+
+				if (fabsf(frame.gainReductiondB) > fabsf(summary.gainReductiondB))
+					summary.gainReductiondB = frame.gainReductiondB;
+
+				sumSQ += (double)frame.rms * frame.rms * frame.samples;
+				summary.samples += frame.samples;
+			}
+
+			frameCount += count;
+		}
+
+		if (summary.samples > 0)
+			summary.rms = (float)std::sqrt(sumSQ / summary.samples);
+
+		return frameCount > 0;
+	}
+
+private:
+	juce::AbstractFifo m_fifo{ CAPACITY };
+	MeterFrame m_frames[CAPACITY];
+};
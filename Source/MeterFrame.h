@@ -0,0 +1,22 @@
+/*
+  ==============================================================================
+
+    MeterFrame.h
+
+    Meter summary of one processed block, written by CrestCompressorCore and
+    passed on to the editor through MeterFifo (Meter.h).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+struct MeterFrame
+{
+	float crestFactor = 0.0f;		// Maximum skewed crest factor, in Threshold parameter units
+	float gainReductiondB = 0.0f;	// Largest smoothed gain change, negative when compressing
+	float peak = 0.0f;				// Input peak, linear
+	float rms = 0.0f;				// Input RMS, linear
+	int samples = 0;				// Block length the frame covers
+};
@@ -0,0 +1,276 @@
+/*
+  ==============================================================================
+
+    Oversampler.h
+
+    2x and 4x up and down sampling for any number of rows, from cascaded
+    linear phase halfband FIR stages. Every second tap of a halfband is zero
+    but the center one, so each stage runs polyphase: one branch is a
+    symmetric FIR at the lower rate, the other a pure delay. The first stage
+    is steep (63 taps, flat to 0.42 fs), the second only removes images far
+    above the band (19 taps). Rows are independent, e.g. one per channel and
+    band, up and down state of a row are separate. Latency of up followed by
+    down is a whole number of base rate samples. Storage is sized in
+    prepare(), a row's history moves in block copies. The symmetric FIR is a
+    DspKernels kernel, built per instruction set, see setKernels().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "DspKernels.h"
+
+//==============================================================================
+template <typename SampleType>
+class Oversampler
+{
+public:
+	static const int MAX_FACTOR = 4;
+
+	// Not real time safe
+	void prepare(int rows, int maxBlockSamples)
+	{
+		m_first.prepare(FIRST_HALF_LENGTH, rows, maxBlockSamples);
+		m_second.prepare(SECOND_HALF_LENGTH, rows, 2 * maxBlockSamples);
+		m_middle.assign((size_t)(2 * maxBlockSamples), SampleType(0));
+		m_alignment.assign((size_t)rows, SampleType(0));
+	}
+
+	// Kernels of one instruction set, see DspKernels::getTable(). Scalar until set.
+	void setKernels(const DspKernels::Table<SampleType>& kernels)
+	{
+		m_first.setKernels(kernels);
+		m_second.setKernels(kernels);
+	}
+
+	void reset()
+	{
+		m_first.reset();
+		m_second.reset();
+		std::fill(m_alignment.begin(), m_alignment.end(), SampleType(0));
+	}
+
+	// 1, 2 or 4, 1 passes through. State is reset.
+	void setFactor(int factor)
+	{
+		m_factor = (factor >= 4) ? 4 : (factor >= 2) ? 2 : 1;
+		reset();
+	}
+
+	int getFactor() const { return m_factor; }
+
+	// Base rate samples from the input of upsample() to the output of downsample(). The 4x
+	// down path delays one sample at 2x, so its half sample fraction rounds up.
+	int getLatencySamples() const
+	{
+		if (m_factor == 1)
+			return 0;
+
+		const int first = m_first.getCenter();
+		return (m_factor == 2) ? first : first + (m_second.getCenter() + 1) / 2;
+	}
+
+	// Base rate in[0 .. samples), samples up to the prepared maximum, to out[0 .. samples * factor). Base sample n lands on out[n * factor]
+	// before the filter delay, the same for every row.
+	void upsample(int row, const SampleType* in, SampleType* out, int samples)
+	{
+		if (m_factor == 1)
+			std::copy(in, in + samples, out);
+		else if (m_factor == 2)
+			m_first.upsample(row, in, out, samples);
+		else
+		{
+			m_first.upsample(row, in, m_middle.data(), samples);
+			m_second.upsample(row, m_middle.data(), out, 2 * samples);
+		}
+	}
+
+	// in[0 .. samples * factor) back to base rate out[0 .. samples), out may be in
+	void downsample(int row, const SampleType* in, SampleType* out, int samples)
+	{
+		if (m_factor == 1)
+		{
+			std::copy(in, in + samples, out);
+			return;
+		}
+
+		if (m_factor == 2)
+		{
+			m_first.downsample(row, in, out, samples);
+			return;
+		}
+
+		SampleType* middle = m_middle.data();
+		const int middleSamples = 2 * samples;
+		m_second.downsample(row, in, middle, middleSamples);
+
+		// One sample of delay at 2x
+		const SampleType last = middle[middleSamples - 1];
+		std::copy_backward(middle, middle + middleSamples - 1, middle + middleSamples);
+		middle[0] = m_alignment[(size_t)row];
+		m_alignment[(size_t)row] = last;
+
+		m_first.downsample(row, middle, out, samples);
+	}
+
+private:
+	// Taps are 4 * k + 3, k = 15 and 4. Kaiser beta 8, about -80 dB stop band.
+	static const int FIRST_HALF_LENGTH = 15;
+	static const int SECOND_HALF_LENGTH = 4;
+
+	//==============================================================================
+	// One 2x stage. Halfband h of 4 * k + 3 taps around center c = 2 * k + 1: the taps at odd
+	// offsets from c form a symmetric FIR of 2 * k + 2 taps, the only other nonzero one is
+	// h[c] = 0.5, a delay of k samples at the lower rate.
+	class HalfBand
+	{
+	public:
+		void prepare(int k, int rows, int maxLowSamples)
+		{
+			m_k = k;
+			m_taps.assign((size_t)(2 * k + 2), SampleType(0));
+
+			const int length = 4 * k + 3;
+			const int center = 2 * k + 1;
+			const double beta = 8.0;
+			const double pi = 3.14159265358979323846;
+			double sum = 0.0;
+			std::vector<double> taps(m_taps.size());
+
+			for (int tap = 0; tap < (int)taps.size(); ++tap)
+			{
+				// Every second filter index, all at odd offsets from the center
+				const int index = 2 * tap;
+				const double offset = (double)(index - center);
+				const double position = 2.0 * index / (length - 1) - 1.0;
+				const double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - position * position))) / besselI0(beta);
+
+				taps[(size_t)tap] = std::sin(pi * offset * 0.5) / (pi * offset) * window;
+				sum += taps[(size_t)tap];
+			}
+
+			// Branch gain 1 at DC, twice the halfband taps, which makes up for the zeros stuffed by upsampling
+			for (size_t tap = 0; tap < taps.size(); ++tap)
+				m_taps[tap] = (SampleType)(taps[tap] / sum);
+
+			const int history = getHistory();
+			m_upHistory.assign((size_t)(rows * history), SampleType(0));
+			m_evenHistory.assign((size_t)(rows * history), SampleType(0));
+			m_oddHistory.assign((size_t)(rows * (k + 1)), SampleType(0));
+
+			m_line.assign((size_t)(history + maxLowSamples), SampleType(0));
+			m_oddLine.assign((size_t)(k + 1 + maxLowSamples), SampleType(0));
+			m_branch.assign((size_t)maxLowSamples, SampleType(0));
+		}
+
+		void setKernels(const DspKernels::Table<SampleType>& kernels) { m_kernels = &kernels; }
+
+		void reset()
+		{
+			std::fill(m_upHistory.begin(), m_upHistory.end(), SampleType(0));
+			std::fill(m_evenHistory.begin(), m_evenHistory.end(), SampleType(0));
+			std::fill(m_oddHistory.begin(), m_oddHistory.end(), SampleType(0));
+		}
+
+		// Delay of the filter at the higher rate
+		int getCenter() const { return 2 * m_k + 1; }
+
+		// samples at the lower rate in, 2 * samples out
+		void upsample(int row, const SampleType* in, SampleType* out, int samples)
+		{
+			const int history = getHistory();
+			SampleType* line = m_line.data();
+			SampleType* rowHistory = m_upHistory.data() + row * history;
+
+			std::copy(rowHistory, rowHistory + history, line);
+			std::copy(in, in + samples, line + history);
+			std::copy(line + samples, line + samples + history, rowHistory);
+
+			m_kernels->halfBand(line, m_branch.data(), samples, m_taps.data(), m_k + 1);
+
+			const SampleType* branch = m_branch.data();
+			const SampleType* delayed = line + history - m_k;
+
+			for (int sample = 0; sample < samples; ++sample)
+			{
+				out[2 * sample] = branch[sample];
+				out[2 * sample + 1] = delayed[sample];
+			}
+		}
+
+		// 2 * samples at the higher rate in, samples out, out may be in
+		void downsample(int row, const SampleType* in, SampleType* out, int samples)
+		{
+			const int history = getHistory();
+			const int oddHistory = m_k + 1;
+			SampleType* even = m_line.data();
+			SampleType* odd = m_oddLine.data();
+			SampleType* rowEven = m_evenHistory.data() + row * history;
+			SampleType* rowOdd = m_oddHistory.data() + row * oddHistory;
+
+			std::copy(rowEven, rowEven + history, even);
+			std::copy(rowOdd, rowOdd + oddHistory, odd);
+
+			for (int sample = 0; sample < samples; ++sample)
+			{
+				even[history + sample] = in[2 * sample];
+				odd[oddHistory + sample] = in[2 * sample + 1];
+			}
+
+			std::copy(even + samples, even + samples + history, rowEven);
+			std::copy(odd + samples, odd + samples + oddHistory, rowOdd);
+
+			m_kernels->halfBand(even, m_branch.data(), samples, m_taps.data(), m_k + 1);
+
+			// Odd phase input k + 1 samples back meets the center tap
+			const SampleType* branch = m_branch.data();
+
+			for (int sample = 0; sample < samples; ++sample)
+				out[sample] = SampleType(0.5) * (branch[sample] + odd[sample]);
+		}
+
+	private:
+		int getHistory() const { return (int)m_taps.size() - 1; }
+
+		static double besselI0(double x)
+		{
+			double sum = 1.0;
+			double term = 1.0;
+
+			for (int k = 1; k < 32; ++k)
+			{
+				term *= (x * 0.5 / k) * (x * 0.5 / k);
+				sum += term;
+			}
+
+			return sum;
+		}
+
+		int m_k = 0;
+		std::vector<SampleType> m_taps;
+		const DspKernels::Table<SampleType>* m_kernels = &DspKernels::getTable<SampleType>(DspKernels::InstructionSet::Scalar);
+
+		// Per row, last inputs before the block
+		std::vector<SampleType> m_upHistory;
+		std::vector<SampleType> m_evenHistory;
+		std::vector<SampleType> m_oddHistory;
+
+		// Block scratch, rows run one after another
+		std::vector<SampleType> m_line;
+		std::vector<SampleType> m_oddLine;
+		std::vector<SampleType> m_branch;
+	};
+
+	HalfBand m_first;
+	HalfBand m_second;
+
+	// 2x signal between the stages of 4x, and the one sample delay of each row's 4x down path
+	std::vector<SampleType> m_middle;
+	std::vector<SampleType> m_alignment;
+
+	int m_factor = 1;
+};
@@ -39,44 +39,102 @@ CrestCompressorAudioProcessorEditor::CrestCompressorAudioProcessorEditor (CrestC
 		m_sliderAttachment[i].reset(new SliderAttachment(valueTreeState, CrestCompressorAudioProcessor::paramsNames[i], slider));
 	}
 
-#if DEBUG
-	crestFactorLabel.setText("Crest: 0", juce::dontSendNotification);
-	crestFactorLabel.setFont(juce::Font(24.0f * 0.01f * SCALE, juce::Font::bold));
-	crestFactorLabel.setJustificationType(juce::Justification::left);
-	addAndMakeVisible(crestFactorLabel);
-
-	gainReductionLabel.setText("GR: 0", juce::dontSendNotification);
-	gainReductionLabel.setFont(juce::Font(24.0f * 0.01f * SCALE, juce::Font::bold));
-	gainReductionLabel.setJustificationType(juce::Justification::left);
-	addAndMakeVisible(gainReductionLabel);
-#endif
-
-#if DEBUG
-	setSize((int)(SLIDER_WIDTH * 0.01f * SCALE * N_SLIDERS_COUNT), (int)(SLIDER_WIDTH * 0.01f * SCALE) + MENU_HEIGHT);
-
-	startTimerHz(8);
-#else
-	setSize((int)(SLIDER_WIDTH * 0.01f * SCALE * N_SLIDERS_COUNT), (int)(SLIDER_WIDTH * 0.01f * SCALE));
-#endif
+	// Bands 2 to 4, smaller knobs in one row
+	for (int i = 0; i < N_BAND_SLIDERS_COUNT; i++)
+	{
+		auto& label = m_bandLabels[i];
+		auto& slider = m_bandSliders[i];
+		const auto& name = CrestCompressorAudioProcessor::bandParamsNames[i];
+
+		//Lable
+		label.setText(name, juce::dontSendNotification);
+		label.setFont(juce::Font(18.0f * 0.01f * SCALE, juce::Font::bold));
+		label.setJustificationType(juce::Justification::centred);
+		addAndMakeVisible(label);
+
+		//Slider
+		slider.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+		slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 16);
+		addAndMakeVisible(slider);
+		m_bandSliderAttachment[i].reset(new SliderAttachment(valueTreeState, name, slider));
+	}
+
+	for (int i = 0; i < N_CHOICES_COUNT; i++)
+	{
+		auto& label = m_choiceLabels[i];
+		auto& comboBox = m_comboBoxes[i];
+		const auto& name = CrestCompressorAudioProcessor::choiceNames[i];
+
+		//Lable
+		label.setText(name, juce::dontSendNotification);
+		label.setFont(juce::Font(18.0f * 0.01f * SCALE, juce::Font::bold));
+		label.setJustificationType(juce::Justification::centredRight);
+		addAndMakeVisible(label);
+
+		//ComboBox, items must exist before the attachment is created
+		if (auto* choiceParameter = dynamic_cast<juce::AudioParameterChoice*>(valueTreeState.getParameter(name)))
+			comboBox.addItemList(choiceParameter->choices, 1);
+
+		addAndMakeVisible(comboBox);
+		m_comboBoxAttachment[i].reset(new ComboBoxAttachment(valueTreeState, name, comboBox));
+	}
+
+	// Meters
+	juce::Label* meterLabels[] = { &peakLabel, &rmsLabel, &gainReductionLabel, &crestFactorLabel, &dspLoadLabel, &overBudgetLabel };
+	const char* meterTexts[] = { "Peak: -inf", "RMS: -inf", "GR: 0", "Crest: 0", "DSP: 0 / 0%", "Late: 0" };
+
+	for (int i = 0; i < 6; i++)
+	{
+		meterLabels[i]->setText(meterTexts[i], juce::dontSendNotification);
+		meterLabels[i]->setFont(juce::Font(24.0f * 0.01f * SCALE, juce::Font::bold));
+		meterLabels[i]->setJustificationType(juce::Justification::left);
+		addAndMakeVisible(meterLabels[i]);
+	}
+
+	addAndMakeVisible(m_history);
+
+	setSize((int)(SLIDER_WIDTH * 0.01f * SCALE * N_SLIDERS_COUNT), (int)(SLIDER_WIDTH * 0.01f * SCALE) + BAND_ROW_HEIGHT + CHOICES_HEIGHT + MENU_HEIGHT + HISTORY_HEIGHT);
+
+	// Block timing only while someone looks at it
+	audioProcessor.getProfiler().reset();
+	audioProcessor.getProfiler().setEnabled(true);
+
+	startTimerHz(TIMER_HZ);
 }
 
 CrestCompressorAudioProcessorEditor::~CrestCompressorAudioProcessorEditor()
 {
+	audioProcessor.getProfiler().setEnabled(false);
 }
 
 //==============================================================================
-#ifdef DEBUG
 void CrestCompressorAudioProcessorEditor::timerCallback()
 {
-	const int crestFactorSQ = (int)audioProcessor.getCrestFactor();
-	crestFactorLabel.setText("Crest: " + juce::String(crestFactorSQ), juce::dontSendNotification);
+	// Mean and worst share of the block period used by processBlock, blocks over budget
+	const auto stats = audioProcessor.getProfiler().getStats();
+	dspLoadLabel.setText("DSP: " + juce::String(juce::roundToInt(stats.getMeanUsage() * 100.0)) + " / " + juce::String(juce::roundToInt(stats.worstUsage * 100.0)) + "%", juce::dontSendNotification);
+	overBudgetLabel.setText("Late: " + juce::String((juce::int64)stats.overBudget), juce::dontSendNotification);
+
+	// Everything the audio thread produced since the last tick, every frame also goes to the history
+	MeterFrame meter;
+	const double sampleRate = audioProcessor.getSampleRate();
+
+	if (! audioProcessor.getMeterFifo().popSummary(meter, [this, sampleRate](const MeterFrame& frame) { m_history.addFrame(frame, sampleRate); }))
+		return;
 
-	const int gainReduction = (int)audioProcessor.getGainReduction();
+	// Draws only the completed columns and repaints only its own bounds
+	m_history.update();
+
+	// Labels repaint themselves when their text changes
+	const int crestFactor = (int)meter.crestFactor;
+	crestFactorLabel.setText("Crest: " + juce::String(crestFactor), juce::dontSendNotification);
+
+	const int gainReduction = (int)meter.gainReductiondB;
 	gainReductionLabel.setText("GR: " + juce::String(gainReduction), juce::dontSendNotification);
-	
-	repaint();
+
+	peakLabel.setText("Peak: " + juce::Decibels::toString(juce::Decibels::gainToDecibels(meter.peak), 1), juce::dontSendNotification);
+	rmsLabel.setText("RMS: " + juce::Decibels::toString(juce::Decibels::gainToDecibels(meter.rms), 1), juce::dontSendNotification);
 }
-#endif
 
 void CrestCompressorAudioProcessorEditor::paint (juce::Graphics& g)
 {
@@ -87,11 +145,7 @@ void CrestCompressorAudioProcessorEditor::resized()
 {
 	int width = getWidth() / N_SLIDERS_COUNT;
 
-#if DEBUG
-	int height = getHeight() - MENU_HEIGHT;
-#else
-	int height = getHeight();
-#endif
+	int height = getHeight() - BAND_ROW_HEIGHT - CHOICES_HEIGHT - MENU_HEIGHT - HISTORY_HEIGHT;
 	
 	// Sliders + Menus
 	juce::Rectangle<int> rectangles[N_SLIDERS_COUNT];
@@ -106,30 +160,64 @@ void CrestCompressorAudioProcessorEditor::resized()
 		m_labels[i].setBounds(rectangles[i]);
 	}
 
-#if DEBUG
-	// Debug menus
-	juce::Rectangle<int> debugMenuRectangle;
+	// Band sliders
+	const int bandWidth = getWidth() / N_BAND_SLIDERS_COUNT;
+	juce::Rectangle<int> bandRectangle;
+
+	for (int i = 0; i < N_BAND_SLIDERS_COUNT; ++i)
+	{
+		bandRectangle.setSize(bandWidth, BAND_ROW_HEIGHT);
+		bandRectangle.setPosition(i * bandWidth, height);
+		m_bandSliders[i].setBounds(bandRectangle);
+
+		bandRectangle.removeFromBottom((int)(16.0f * 0.01f * SCALE));
+		m_bandLabels[i].setBounds(bandRectangle);
+	}
+
+	// Choices, label and combo box share one slider column
+	juce::Rectangle<int> choiceRectangle;
+	const int choicePosY = (int)(height + BAND_ROW_HEIGHT + CHOICES_HEIGHT * 0.2f);
+	choiceRectangle.setSize(width / 2, (int)(CHOICES_HEIGHT * 0.6f));
+
+	for (int i = 0; i < N_CHOICES_COUNT; ++i)
+	{
+		choiceRectangle.setPosition(i * width, choicePosY);
+		m_choiceLabels[i].setBounds(choiceRectangle);
+
+		choiceRectangle.setPosition(i * width + width / 2, choicePosY);
+		m_comboBoxes[i].setBounds(choiceRectangle);
+	}
+
+	// Meters
+	juce::Rectangle<int> meterRectangle;
 	const int menuWidth = (int)(width * 0.9f);
-	const int debugMenuPosY = (int)(height + MENU_HEIGHT * 0.3f);
-	debugMenuRectangle.setSize(menuWidth, (int)(MENU_HEIGHT * 0.4f));
+	const int meterPosY = (int)(height + BAND_ROW_HEIGHT + CHOICES_HEIGHT + MENU_HEIGHT * 0.3f);
+	meterRectangle.setSize(menuWidth, (int)(MENU_HEIGHT * 0.4f));
 
 	//1
-	debugMenuRectangle.setPosition((int)(0.05f * width), debugMenuPosY);
+	meterRectangle.setPosition((int)(0.05f * width), meterPosY);
+	peakLabel.setBounds(meterRectangle);
 
 	//2
-	debugMenuRectangle.setPosition((int)(1.05f * width), debugMenuPosY);
+	meterRectangle.setPosition((int)(1.05f * width), meterPosY);
+	rmsLabel.setBounds(meterRectangle);
 
 	//3
-	debugMenuRectangle.setPosition((int)(2.05f * width), debugMenuPosY);
-	gainReductionLabel.setBounds(debugMenuRectangle);
+	meterRectangle.setPosition((int)(2.05f * width), meterPosY);
+	gainReductionLabel.setBounds(meterRectangle);
 
 	//4
-	debugMenuRectangle.setPosition((int)(3.05f * width), debugMenuPosY);
-	crestFactorLabel.setBounds(debugMenuRectangle);
+	meterRectangle.setPosition((int)(3.05f * width), meterPosY);
+	crestFactorLabel.setBounds(meterRectangle);
 
 	//5
-	debugMenuRectangle.setPosition((int)(4.05f * width), debugMenuPosY);
+	meterRectangle.setPosition((int)(4.05f * width), meterPosY);
+	dspLoadLabel.setBounds(meterRectangle);
 
 	//6
-#endif
+	meterRectangle.setPosition((int)(5.05f * width), meterPosY);
+	overBudgetLabel.setBounds(meterRectangle);
+
+	// History, full width below the meters
+	m_history.setBounds(0, height + BAND_ROW_HEIGHT + CHOICES_HEIGHT + MENU_HEIGHT, getWidth(), HISTORY_HEIGHT);
 }
\ No newline at end of file
@@ -10,32 +10,31 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "HistoryDisplay.h"
 
 //==============================================================================
-#if DEBUG
 class CrestCompressorAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Timer
-#else
-class CrestCompressorAudioProcessorEditor : public juce::AudioProcessorEditor
-#endif
 {
 public:
     CrestCompressorAudioProcessorEditor (CrestCompressorAudioProcessor&, juce::AudioProcessorValueTreeState&);
     ~CrestCompressorAudioProcessorEditor() override;
 
 	// GUI setup
-	static const int N_SLIDERS_COUNT = 6;
+	static const int N_SLIDERS_COUNT = 8;
+	static const int N_BAND_SLIDERS_COUNT = 9;
+	static const int N_CHOICES_COUNT = 6;
 	static const int SCALE = 70;
 	static const int SLIDER_WIDTH = 200;
 	static const int HUE = 10;
+	static const int CHOICES_HEIGHT = 40;
+	static const int BAND_ROW_HEIGHT = 110;
 
-#ifdef DEBUG
 	static const int MENU_HEIGHT = 60;
-#endif
+	static const int HISTORY_HEIGHT = 120;
+	static const int TIMER_HZ = 30;
 
     //==============================================================================
-#ifdef DEBUG
 	void timerCallback() override;
-#endif
 	void paint (juce::Graphics&) override;
     void resized() override;
 
@@ -51,10 +50,22 @@ private:
 	juce::Slider m_sliders[N_SLIDERS_COUNT] = {};
 	std::unique_ptr<SliderAttachment> m_sliderAttachment[N_SLIDERS_COUNT] = {};
 
-#ifdef DEBUG
+	juce::Label m_bandLabels[N_BAND_SLIDERS_COUNT] = {};
+	juce::Slider m_bandSliders[N_BAND_SLIDERS_COUNT] = {};
+	std::unique_ptr<SliderAttachment> m_bandSliderAttachment[N_BAND_SLIDERS_COUNT] = {};
+
+	juce::Label m_choiceLabels[N_CHOICES_COUNT] = {};
+	juce::ComboBox m_comboBoxes[N_CHOICES_COUNT] = {};
+	std::unique_ptr<ComboBoxAttachment> m_comboBoxAttachment[N_CHOICES_COUNT] = {};
+
+	juce::Label peakLabel;
+	juce::Label rmsLabel;
 	juce::Label gainReductionLabel;
-	juce::Label crestFactorLabel;	
-#endif
+	juce::Label crestFactorLabel;
+	juce::Label dspLoadLabel;
+	juce::Label overBudgetLabel;
+
+	HistoryDisplay m_history;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CrestCompressorAudioProcessorEditor)
 };
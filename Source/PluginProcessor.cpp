@@ -9,44 +9,23 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-//==============================================================================
-EnvelopeFollower::EnvelopeFollower()
-{
-}
-
-void EnvelopeFollower::setCoef(float attackTimeMs, float releaseTimeMs)
-{
-	m_AttackCoef = exp(-1000.0f / (attackTimeMs * m_SampleRate));
-	m_ReleaseCoef = exp(-1000.0f / (releaseTimeMs * m_SampleRate));
-
-	m_One_Minus_AttackCoef = 1.0f - m_AttackCoef;
-	m_One_Minus_ReleaseCoef = 1.0f - m_ReleaseCoef;
-}
-
-float EnvelopeFollower::process(float in)
-{
-	const float inAbs = fabs(in);
-	m_Out1Last = fmaxf(inAbs, m_ReleaseCoef * m_Out1Last + m_One_Minus_ReleaseCoef * inAbs);
-	return m_OutLast = m_AttackCoef * m_OutLast + m_One_Minus_AttackCoef * m_Out1Last;
-}
-
-const std::string CrestCompressorAudioProcessor::paramsNames[] = { "Smooth", "Lenght", "Attack", "Threshold", "Mix", "Volume" };
-const float CrestCompressorAudioProcessor::CREST_LIMIT = 50.0f;
+const std::string CrestCompressorAudioProcessor::paramsNames[] = { "Smooth", "Lenght", "Attack", "Threshold", "Mix", "Volume", "Lookahead", "Window" };
+const std::string CrestCompressorAudioProcessor::choiceNames[] = { "Kernel", "Bands", "Detector", "Rate", "Link", "Oversampling" };
+const std::string CrestCompressorAudioProcessor::bandParamsNames[] = { "Crossover1", "Threshold2", "Ratio2", "Crossover2", "Threshold3", "Ratio3", "Crossover3", "Threshold4", "Ratio4" };
 
 //==============================================================================
-CrestFactor::CrestFactor()
+namespace
 {
-}
-
-float CrestFactor::process(float in)
-{
-	const float inSQ = in * in;
-	const float inFactor = (1.0f - m_Coef) * inSQ;
+	// FNV-1a of a parameter ID, stable across builds and platforms unlike String::hashCode
+	juce::uint32 hashParameterID(const juce::String& parameterID)
+	{
+		juce::uint32 hash = 2166136261u;
 
-	m_PeakLastSQ = std::max(inSQ, m_Coef * m_PeakLastSQ + inFactor);
-	m_RMSLastSQ = m_Coef * m_RMSLastSQ + inFactor;
+		for (auto* character = parameterID.toRawUTF8(); *character != 0; ++character)
+			hash = (hash ^ (juce::uint8)*character) * 16777619u;
 
-	return std::sqrtf(m_PeakLastSQ / m_RMSLastSQ);
+		return hash;
+	}
 }
 //==============================================================================
 CrestCompressorAudioProcessor::CrestCompressorAudioProcessor()
@@ -55,6 +34,7 @@ CrestCompressorAudioProcessor::CrestCompressorAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -63,14 +43,48 @@ CrestCompressorAudioProcessor::CrestCompressorAudioProcessor()
 {
 	attackParameter    = apvts.getRawParameterValue(paramsNames[0]);
 	releaseParameter   = apvts.getRawParameterValue(paramsNames[1]);
-	ratioParameter     = apvts.getRawParameterValue(paramsNames[2]);
-	thresholdParameter = apvts.getRawParameterValue(paramsNames[3]);
+	ratioParameters[0] = apvts.getRawParameterValue(paramsNames[2]);
+	thresholdParameters[0] = apvts.getRawParameterValue(paramsNames[3]);
 	mixParameter       = apvts.getRawParameterValue(paramsNames[4]);
 	volumeParameter    = apvts.getRawParameterValue(paramsNames[5]);
+	lookaheadParameter = apvts.getRawParameterValue(paramsNames[6]);
+	windowParameter    = apvts.getRawParameterValue(paramsNames[7]);
+
+	kernelParameter    = apvts.getRawParameterValue(choiceNames[0]);
+	bandsParameter     = apvts.getRawParameterValue(choiceNames[1]);
+	detectorParameter  = apvts.getRawParameterValue(choiceNames[2]);
+	rateParameter      = apvts.getRawParameterValue(choiceNames[3]);
+	linkParameter      = apvts.getRawParameterValue(choiceNames[4]);
+	oversamplingParameter = apvts.getRawParameterValue(choiceNames[5]);
+
+	for (int band = 1; band < MAX_BANDS; ++band)
+	{
+		crossoverParameters[band - 1] = apvts.getRawParameterValue(bandParamsNames[(band - 1) * 3]);
+		thresholdParameters[band]     = apvts.getRawParameterValue(bandParamsNames[(band - 1) * 3 + 1]);
+		ratioParameters[band]         = apvts.getRawParameterValue(bandParamsNames[(band - 1) * 3 + 2]);
+	}
+
+	// Binary state entries are found by ID hash
+	for (auto* parameter : getParameters())
+		if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+			m_stateParameters.push_back({ hashParameterID(ranged->paramID), ranged });
+
+	// Factory programs, plain values. Attack is the ratio, negative compresses.
+	const auto& parameters = getParameters();
+
+	m_presets.addPreset("Default", parameters, {});
+	m_presets.addPreset("Transient Tamer", parameters, { { "Attack", -8.0f }, { "Threshold", 20.0f }, { "Smooth", 1.0f }, { "Lenght", 80.0f } });
+	m_presets.addPreset("Drum Punch", parameters, { { "Attack", 10.0f }, { "Threshold", 15.0f }, { "Smooth", 0.5f }, { "Lenght", 60.0f }, { "Mix", 0.7f } });
+	m_presets.addPreset("Gentle Glue", parameters, { { "Attack", -4.0f }, { "Threshold", 25.0f }, { "Smooth", 5.0f }, { "Lenght", 150.0f }, { "Mix", 0.6f } });
+	m_presets.addPreset("Lookahead Peak Control", parameters, { { "Attack", -16.0f }, { "Threshold", 18.0f }, { "Smooth", 0.1f }, { "Lenght", 50.0f },
+	                                                           { "Lookahead", 5.0f }, { "Detector", 1.0f }, { "Window", 50.0f } });
+	m_presets.addPreset("Multiband Drums", parameters, { { "Bands", 2.0f }, { "Attack", 8.0f }, { "Threshold", 15.0f }, { "Crossover1", 150.0f },
+	                                                    { "Threshold2", 20.0f }, { "Ratio2", 6.0f }, { "Crossover2", 2500.0f }, { "Threshold3", 18.0f }, { "Ratio3", 4.0f } });
 }
 
 CrestCompressorAudioProcessor::~CrestCompressorAudioProcessor()
 {
+	cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -108,44 +122,101 @@ bool CrestCompressorAudioProcessor::isMidiEffect() const
 
 double CrestCompressorAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+	// Lookahead and oversampling filter delay keep sounding after the input stops
+	const double sampleRate = getSampleRate();
+	return (sampleRate > 0.0) ? getLatencySamples() / sampleRate : lookaheadParameter->load() * 0.001;
 }
 
 int CrestCompressorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+	return m_presets.getNumPresets();
 }
 
 int CrestCompressorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+	return m_currentProgram.load();
 }
 
+// Any thread, hosts also change programs from the audio thread. Parameters are set from the precomputed
+// snapshot on the message thread, right away when called there.
 void CrestCompressorAudioProcessor::setCurrentProgram (int index)
 {
+	if (! juce::isPositiveAndBelow(index, m_presets.getNumPresets()))
+		return;
+
+	m_currentProgram.store(index);
+	m_pendingProgram.store(index);
+
+	if (juce::MessageManager::existsAndIsCurrentThread())
+	{
+		cancelPendingUpdate();
+		handleAsyncUpdate();
+	}
+	else
+	{
+		triggerAsyncUpdate();
+	}
+}
+
+// Message thread: a pending program change, then Window detector history the parameters need
+void CrestCompressorAudioProcessor::handleAsyncUpdate()
+{
+	const int index = m_pendingProgram.exchange(-1);
+
+	if (index >= 0)
+		m_presets.apply(index, getParameters());
+
+	const auto parameters = getCoreParameters();
+	const bool doublePrecision = isUsingDoublePrecision();
+
+	if (doublePrecision ? ! m_doubleCore.needsWindowStorage(parameters) : ! m_floatCore.needsWindowStorage(parameters))
+		return;
+
+	// Allocates, so no block may run meanwhile. The host's own suspension is kept.
+	const bool suspended = isSuspended();
+	suspendProcessing(true);
+
+	if (doublePrecision)
+		m_doubleCore.prepareWindow(parameters);
+	else
+		m_floatCore.prepareWindow(parameters);
+
+	suspendProcessing(suspended);
 }
 
 const juce::String CrestCompressorAudioProcessor::getProgramName (int index)
 {
-    return {};
+	return m_presets.getName(index);
 }
 
 void CrestCompressorAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+	m_presets.setName(index, newName);
 }
 
 //==============================================================================
 void CrestCompressorAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-	m_envelopeFollower[0].init((int)(sampleRate));
-	m_envelopeFollower[1].init((int)(sampleRate));
+	// Sidechain keys the detector when enabled, its channels are read in place from the processBlock buffer
+	const auto* sidechain = getBusCount(true) > 1 ? getBus(true, 1) : nullptr;
+	m_sidechainChannels = (sidechain != nullptr && sidechain->isEnabled()) ? sidechain->getNumberOfChannels() : 0;
+	m_sidechainFirstChannel = (m_sidechainChannels > 0) ? getChannelIndexInProcessBlockBuffer(true, 1, 0) : 0;
 
-	m_crestFactorCalculator[0].init((int)(sampleRate));
-	m_crestFactorCalculator[1].init((int)(sampleRate));
+	// Signal path for every channel of the current layout, in the host's precision. Smoothers start at the current values.
+	const int channels = getTotalNumOutputChannels();
 
-	m_crestFactorCalculator[0].setCoef(0.1f);
-	m_crestFactorCalculator[1].setCoef(0.1f);
+	if (isUsingDoublePrecision())
+	{
+		m_doubleCore.prepare(channels, sampleRate, getCoreParameters(), m_instructionSet);
+		m_floatCore = CrestCompressorCore<float>();
+		setLatencySamples(m_doubleCore.getLatencySamples());
+	}
+	else
+	{
+		m_floatCore.prepare(channels, sampleRate, getCoreParameters(), m_instructionSet);
+		m_doubleCore = CrestCompressorCore<double>();
+		setLatencySamples(m_floatCore.getLatencySamples());
+	}
 }
 
 void CrestCompressorAudioProcessor::releaseResources()
@@ -160,18 +231,20 @@ bool CrestCompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any channel count, detector state is sized in prepareToPlay
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // Optional sidechain, mono keys every channel, otherwise channels map one to one
+    const auto sidechain = layouts.getChannelSet(true, 1);
+
+    if (! sidechain.isDisabled() && sidechain != juce::AudioChannelSet::mono() && sidechain != layouts.getMainOutputChannelSet())
+        return false;
    #endif
 
     return true;
@@ -179,72 +252,79 @@ bool CrestCompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
 }
 #endif
 
+CrestCompressorParameters CrestCompressorAudioProcessor::getCoreParameters() const
+{
+	CrestCompressorParameters parameters;
+
+	parameters.smooth = attackParameter->load();
+	parameters.length = releaseParameter->load();
+	parameters.mix = mixParameter->load();
+	parameters.volume = volumeParameter->load();
+	parameters.lookahead = lookaheadParameter->load();
+	parameters.window = windowParameter->load();
+	parameters.kernel = (Kernel)juce::jlimit(0, 1, (int)kernelParameter->load());
+	parameters.detector = (Detector)juce::jlimit(0, 1, (int)detectorParameter->load());
+	parameters.link = (Link)juce::jlimit(0, 3, (int)linkParameter->load());
+	parameters.bands = juce::jlimit(1, MAX_BANDS, (int)bandsParameter->load() + 1);
+
+	const int controlIntervals[] = { 1, 8, 16, 32 };
+	parameters.controlInterval = controlIntervals[juce::jlimit(0, 3, (int)rateParameter->load())];
+
+	const int oversamplingFactors[] = { 1, 2, 4 };
+	parameters.oversampling = oversamplingFactors[juce::jlimit(0, 2, (int)oversamplingParameter->load())];
+
+	for (int band = 0; band < MAX_BANDS; ++band)
+	{
+		parameters.threshold[band] = thresholdParameters[band]->load();
+		parameters.ratio[band] = ratioParameters[band]->load();
+	}
+
+	for (int split = 0; split < MAX_BANDS - 1; ++split)
+		parameters.crossover[split] = crossoverParameters[split]->load();
+
+	return parameters;
+}
+
+bool CrestCompressorAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+	return true;
+}
+
 void CrestCompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-	// Get params
-	const auto ratio = -1.0f * ratioParameter->load();
-	const float attack = (ratio > 0) ? 200.0 - attackParameter->load() : attackParameter->load();
-	const auto release = releaseParameter->load();		
-	const auto threshold = thresholdParameter->load();
-	const auto mix = mixParameter->load();
-	const auto volume = juce::Decibels::decibelsToGain(volumeParameter->load());
-
-	// Mics constants
-	const float attenuationFactor = ratio * 4.0f;
-	const float thresholdNormalized = threshold / CREST_LIMIT;
-	const float mixInverse = 1.0f - mix;
-	const int channels = getTotalNumOutputChannels();
-	const int samples = buffer.getNumSamples();	
+	const auto profileStart = m_profiler.begin();
+	process(buffer, m_floatCore);
+	m_profiler.end(profileStart, buffer.getNumSamples(), getSampleRate());
+}
 
-	for (int channel = 0; channel < channels; ++channel)
-	{
-		// Channel pointer
-		auto* channelBuffer = buffer.getWritePointer(channel);
-		
-		// Envelope reference
-		auto& envelopeFollower = m_envelopeFollower[channel];
-
-		// CrestFactor
-		auto& crestFactorCalculator = m_crestFactorCalculator[channel];
-		
-		// Set attack and release
-		envelopeFollower.setCoef(attack, release);
-
-		const float factor = (ratio > 0.0f) ? -1.0f : 1.0f;
-
-		for (int sample = 0; sample < samples; ++sample)
-		{
-			// Get input
-			const float in = channelBuffer[sample];
-
-			// Get crest factor
-			const float crestFactor = crestFactorCalculator.process(in);
-			const float crestFactorNormalized = std::min(crestFactor / CREST_LIMIT, 1.0f);
-			const float crestSkewed = powf(crestFactorNormalized, 0.5f);
-
-			//Get gain reduction, positive values
-			float attenuatedB = (crestSkewed >= thresholdNormalized) ? (crestSkewed - thresholdNormalized) * attenuationFactor : 0.0f;
-			attenuatedB = std::min(fabsf(attenuatedB), 18.0f);
-
-			// Smooth
-			const float smoothdB = factor * envelopeFollower.process(attenuatedB);
-
-#ifdef DEBUG
-			if (crestSkewed * CREST_LIMIT > m_crestFactorPercentage)
-				m_crestFactorPercentage = crestSkewed * CREST_LIMIT;
-
-			// Store gain reduction
-			if (fabsf(smoothdB) > fabsf(m_gainReductiondB))
-				m_gainReductiondB = smoothdB;
-#endif
+void CrestCompressorAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+	const auto profileStart = m_profiler.begin();
+	process(buffer, m_doubleCore);
+	m_profiler.end(profileStart, buffer.getNumSamples(), getSampleRate());
+}
+
+template <typename SampleType>
+void CrestCompressorAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, CrestCompressorCore<SampleType>& core)
+{
+	const auto parameters = getCoreParameters();
+	core.setParameters(parameters);
 
-			// Apply gain reduction
-			const float out = in * juce::Decibels::decibelsToGain(smoothdB);
+	// Window detector history is allocated on the message thread, the exponential detector stands in meanwhile
+	if (core.needsWindowStorage(parameters))
+		triggerAsyncUpdate();
 
-			// Apply volume, mix and send to output
-			channelBuffer[sample] = volume * (mix * out + mixInverse * in);
-		}
-	}
+	// Sidechain channels follow the main ones in the buffer, the core reads them in place
+	const bool sidechain = m_sidechainChannels > 0 && m_sidechainFirstChannel + m_sidechainChannels <= buffer.getNumChannels();
+	const SampleType* const* key = sidechain ? buffer.getArrayOfReadPointers() + m_sidechainFirstChannel : nullptr;
+
+	core.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples(), key, sidechain ? m_sidechainChannels : 0);
+
+	// Lookahead or oversampling moved, reported on change
+	if (core.getLatencySamples() != getLatencySamples())
+		setLatencySamples(core.getLatencySamples());
+
+	m_meterFifo.push(core.getMeterFrame());
 }
 
 //==============================================================================
@@ -259,15 +339,32 @@ juce::AudioProcessorEditor* CrestCompressorAudioProcessor::createEditor()
 }
 
 //==============================================================================
+// Binary state, little endian:
+//   uint32 STATE_MAGIC, uint16 STATE_VERSION, uint16 program, uint16 count,
+//   count * (uint32 FNV-1a hash of the parameter ID, float plain value)
 void CrestCompressorAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{	
-	auto state = apvts.copyState();
-	std::unique_ptr<juce::XmlElement> xml(state.createXml());
-	copyXmlToBinary(*xml, destData);
+{
+	destData.setSize(0);
+	juce::MemoryOutputStream stream(destData, false);
+
+	stream.writeInt((int)STATE_MAGIC);
+	stream.writeShort((short)STATE_VERSION);
+	stream.writeShort((short)m_currentProgram.load());
+	stream.writeShort((short)m_stateParameters.size());
+
+	for (const auto& entry : m_stateParameters)
+	{
+		stream.writeInt((int)entry.idHash);
+		stream.writeFloat(entry.parameter->convertFrom0to1(entry.parameter->getValue()));
+	}
 }
 
 void CrestCompressorAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+	if (setBinaryState(data, sizeInBytes))
+		return;
+
+	// States saved before the binary format
 	std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
 	if (xmlState.get() != nullptr)
@@ -275,6 +372,60 @@ void CrestCompressorAudioProcessor::setStateInformation (const void* data, int s
 			apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
 }
 
+bool CrestCompressorAudioProcessor::setBinaryState(const void* data, int sizeInBytes)
+{
+	const int headerSize = 10;
+	const int entrySize = 8;
+
+	if (data == nullptr || sizeInBytes < headerSize)
+		return false;
+
+	juce::MemoryInputStream stream(data, (size_t)sizeInBytes, false);
+
+	if ((juce::uint32)stream.readInt() != STATE_MAGIC)
+		return false;
+
+	// Newer versions may change the meaning of entries, the state is rejected and the parameters keep their values
+	const int version = (juce::uint16)stream.readShort();
+	const int program = (juce::uint16)stream.readShort();
+
+	if (version > STATE_VERSION)
+		return false;
+
+	// The state replaces a program change still waiting for the message thread
+	m_pendingProgram.store(-1);
+
+	// Truncated data loads the complete entries, the rest get their default
+	const int count = juce::jmin((int)(juce::uint16)stream.readShort(), (sizeInBytes - headerSize) / entrySize);
+
+	// Parameters missing from the state, e.g. added in a later release, get their default
+	std::vector<float> values;
+	values.reserve(m_stateParameters.size());
+
+	for (const auto& entry : m_stateParameters)
+		values.push_back(entry.parameter->getDefaultValue());
+
+	for (int i = 0; i < count; ++i)
+	{
+		const auto idHash = (juce::uint32)stream.readInt();
+		const float value = stream.readFloat();
+
+		for (size_t parameter = 0; parameter < m_stateParameters.size(); ++parameter)
+			if (m_stateParameters[parameter].idHash == idHash)
+				values[parameter] = m_stateParameters[parameter].parameter->convertTo0to1(value);
+	}
+
+	// One notification per parameter that changes, as PresetBank::apply
+	for (size_t parameter = 0; parameter < m_stateParameters.size(); ++parameter)
+		if (m_stateParameters[parameter].parameter->getValue() != values[parameter])
+			m_stateParameters[parameter].parameter->setValueNotifyingHost(values[parameter]);
+
+	if (juce::isPositiveAndBelow(program, m_presets.getNumPresets()))
+		m_currentProgram.store(program);
+
+	return true;
+}
+
 juce::AudioProcessorValueTreeState::ParameterLayout CrestCompressorAudioProcessor::createParameterLayout()
 {
 	APVTS::ParameterLayout layout;
@@ -287,6 +438,29 @@ juce::AudioProcessorValueTreeState::ParameterLayout CrestCompressorAudioProcesso
 	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[3], paramsNames[3], NormalisableRange<float>(  0.0f, CREST_LIMIT,  1.0f, 1.0f), CREST_LIMIT * 0.5f));
 	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[4], paramsNames[4], NormalisableRange<float>(  0.0f,   1.0f, 0.05f, 1.0f),   1.0f));
 	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[5], paramsNames[5], NormalisableRange<float>(-24.0f,  24.0f,  0.1f, 1.0f),   0.0f));
+	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[6], paramsNames[6], NormalisableRange<float>(  0.0f, LOOKAHEAD_LIMIT_MS, 0.1f, 1.0f), 0.0f));
+	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[7], paramsNames[7], NormalisableRange<float>(  1.0f, WINDOW_LIMIT_MS, 1.0f, 0.5f), 100.0f));
+
+	layout.add(std::make_unique<juce::AudioParameterChoice>(choiceNames[0], choiceNames[0], StringArray{ "Exact", "Fast" }, (int)Kernel::Exact));
+	layout.add(std::make_unique<juce::AudioParameterChoice>(choiceNames[1], choiceNames[1], StringArray{ "1", "2", "3", "4" }, 0));
+	layout.add(std::make_unique<juce::AudioParameterChoice>(choiceNames[2], choiceNames[2], StringArray{ "Exponential", "Window" }, (int)Detector::Exponential));
+	layout.add(std::make_unique<juce::AudioParameterChoice>(choiceNames[3], choiceNames[3], StringArray{ "1", "8", "16", "32" }, 0));
+	layout.add(std::make_unique<juce::AudioParameterChoice>(choiceNames[4], choiceNames[4], StringArray{ "Off", "Max", "Power", "Mid" }, (int)Link::Off));
+	layout.add(std::make_unique<juce::AudioParameterChoice>(choiceNames[5], choiceNames[5], StringArray{ "1x", "2x", "4x" }, 0));
+
+	// Bands 2 to 4, crossover below the band, then threshold and ratio as band 1
+	const float crossoverDefaults[] = { 200.0f, 1000.0f, 5000.0f };
+
+	for (int band = 1; band < MAX_BANDS; ++band)
+	{
+		const auto& crossover = bandParamsNames[(band - 1) * 3];
+		const auto& threshold = bandParamsNames[(band - 1) * 3 + 1];
+		const auto& ratio = bandParamsNames[(band - 1) * 3 + 2];
+
+		layout.add(std::make_unique<juce::AudioParameterFloat>(crossover, crossover, NormalisableRange<float>( 20.0f, 20000.0f,  1.0f, 0.25f), crossoverDefaults[band - 1]));
+		layout.add(std::make_unique<juce::AudioParameterFloat>(threshold, threshold, NormalisableRange<float>(  0.0f, CREST_LIMIT,  1.0f, 1.0f), CREST_LIMIT * 0.5f));
+		layout.add(std::make_unique<juce::AudioParameterFloat>(ratio, ratio, NormalisableRange<float>(-24.0f,  24.0f,  1.0f, 1.0f),   0.0f));
+	}
 
 	return layout;
 }
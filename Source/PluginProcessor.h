@@ -9,51 +9,18 @@
 #pragma once
 
 #include <JuceHeader.h>
-
-//==============================================================================
-class EnvelopeFollower
-{
-public:
-	EnvelopeFollower();
-
-	void init(int sampleRate) { m_SampleRate = sampleRate; }
-	void setCoef(float attackTime, float releaseTime);
-	float process(float in);
-
-protected:
-	int  m_SampleRate = 48000;
-	float m_AttackCoef = 0.0f;
-	float m_One_Minus_AttackCoef = 0.0f;
-	float m_ReleaseCoef = 0.0f;
-	float m_One_Minus_ReleaseCoef = 0.0f;
-	
-	float m_OutLast = 0.0f;
-	float m_Out1Last = 0.0f;
-};
-
-//==============================================================================
-class CrestFactor
-{
-public:
-	CrestFactor();
-
-	void init(int sampleRate) { m_SampleRate = sampleRate; }
-	void setCoef(float time) { m_Coef = exp(-1.0f / (m_SampleRate * time)); }
-	float process(float in);
-
-protected:
-	int  m_SampleRate = 48000;
-	float m_Coef = 0.0f;
-
-	float m_PeakLastSQ = 0.0f;
-	float m_RMSLastSQ = 0.0f;
-};
+#include "BlockProfiler.h"
+#include "CrestCompressorCore.h"
+#include "DspKernels.h"
+#include "Meter.h"
+#include "PresetBank.h"
 
 //==============================================================================
 class CrestCompressorAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::AsyncUpdater
 {
 
 public:
@@ -62,7 +29,31 @@ public:
     ~CrestCompressorAudioProcessor() override;
 
 	static const std::string paramsNames[];
-	static const float CREST_LIMIT;
+	static const std::string choiceNames[];
+
+	// Crossover below each upper band followed by its threshold and ratio, band 1 uses Threshold and Attack
+	static const std::string bandParamsNames[];
+	static constexpr float CREST_LIMIT = CrestCompressorParameters::CREST_LIMIT;
+	static constexpr float ATTENUATION_LIMIT_DB = CrestCompressorParameters::ATTENUATION_LIMIT_DB;
+	static constexpr float LOOKAHEAD_LIMIT_MS = CrestCompressorParameters::LOOKAHEAD_LIMIT_MS;
+	static constexpr float WINDOW_LIMIT_MS = CrestCompressorParameters::WINDOW_LIMIT_MS;
+	static constexpr float SILENCE_LEVEL = CrestCompressorParameters::SILENCE_LEVEL;
+
+	// Signal path, see CrestCompressorCore.h for the choices and limits
+	using Kernel = CrestCompressorParameters::Kernel;
+	using Detector = CrestCompressorParameters::Detector;
+	using Link = CrestCompressorParameters::Link;
+
+	static const int MAX_BANDS = CrestCompressorParameters::MAX_BANDS;
+	static const int MAX_OVERSAMPLING = CrestCompressorParameters::MAX_OVERSAMPLING;
+	static const int CHUNK_SIZE = CrestCompressorCore<float>::CHUNK_SIZE;
+
+	// Binary state header, "CrST", and format version
+	static const juce::uint32 STATE_MAGIC = 0x54537243;
+	static const int STATE_VERSION = 1;
+
+	// Ramp time of threshold, ratio, mix and volume changes in seconds
+	static constexpr double SMOOTHING_TIME = CrestCompressorParameters::SMOOTHING_TIME;
 
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
@@ -73,6 +64,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -97,32 +90,18 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-#ifdef DEBUG
-	float getCrestFactor()
-	{ 
-		const float tmp = m_crestFactorPercentage;
-		m_crestFactorPercentage = 0.0f;
-		return tmp;
-	}
-	float getGainReduction()
-	{
-		const float tmp = m_gainReductiondB;
-		m_gainReductiondB = 0.0f;
-		return tmp;
-	}
-	float getAttackTime()
-	{
-		const float tmp = m_attackTime;
-		m_attackTime = 0.0f;
-		return tmp;
-	}
-	float getReleaseTime()
-	{
-		const float tmp = m_releaseTime;
-		m_releaseTime = 0.0f;
-		return tmp;
-	}
-#endif
+	// Per block meter frames, drained by a single consumer (the editor)
+	MeterFifo& getMeterFifo() { return m_meterFifo; }
+
+	// processBlock cost, disabled until a reader enables it
+	BlockProfiler& getProfiler() { return m_profiler; }
+
+	// Parameter values as the core takes them, choice indices mapped to counts and factors
+	CrestCompressorParameters getCoreParameters() const;
+
+	// Kernel instruction set, the best the CPU supports by default, limited to it. Takes effect at the next prepareToPlay.
+	void setInstructionSet(DspKernels::InstructionSet instructionSet) { m_instructionSet = instructionSet; }
+	DspKernels::InstructionSet getInstructionSet() const { return std::min(m_instructionSet, DspKernels::getBestInstructionSet()); }
 
 	using APVTS = juce::AudioProcessorValueTreeState;
 	static APVTS::ParameterLayout createParameterLayout();
@@ -130,23 +109,62 @@ public:
 	APVTS apvts{ *this, nullptr, "Parameters", createParameterLayout() };
 
 private:	
+	//==============================================================================
+	// processBlock body, shared by the float and double overloads
+	template <typename SampleType>
+	void process(juce::AudioBuffer<SampleType>& buffer, CrestCompressorCore<SampleType>& core);
+
+	// Returns false when data is not a binary state this version can read, true when it was loaded
+	bool setBinaryState(const void* data, int sizeInBytes);
+
+	// Applies the program setCurrentProgram() left in m_pendingProgram and allocates the Window detector
+	// history when process() found none for the current parameters
+	void handleAsyncUpdate() override;
+
 	//==============================================================================
 	std::atomic<float>* attackParameter = nullptr;
 	std::atomic<float>* releaseParameter = nullptr;
-	std::atomic<float>* ratioParameter = nullptr;
-	std::atomic<float>* thresholdParameter = nullptr;
 	std::atomic<float>* mixParameter = nullptr;
 	std::atomic<float>* volumeParameter = nullptr;
+	std::atomic<float>* lookaheadParameter = nullptr;
+	std::atomic<float>* kernelParameter = nullptr;
+	std::atomic<float>* bandsParameter = nullptr;
+	std::atomic<float>* detectorParameter = nullptr;
+	std::atomic<float>* windowParameter = nullptr;
+	std::atomic<float>* rateParameter = nullptr;
+	std::atomic<float>* linkParameter = nullptr;
+	std::atomic<float>* oversamplingParameter = nullptr;
+
+	std::atomic<float>* ratioParameters[MAX_BANDS] = {};
+	std::atomic<float>* thresholdParameters[MAX_BANDS] = {};
+	std::atomic<float>* crossoverParameters[MAX_BANDS - 1] = {};
+
+	// Only the core matching the host's processing precision is allocated in prepareToPlay
+	CrestCompressorCore<float> m_floatCore;
+	CrestCompressorCore<double> m_doubleCore;
+
+	// Sidechain bus channels in the processBlock buffer, 0 when the bus is disabled
+	int m_sidechainChannels = 0;
+	int m_sidechainFirstChannel = 0;
+
+	MeterFifo m_meterFifo;
+	BlockProfiler m_profiler;
+	DspKernels::InstructionSet m_instructionSet = DspKernels::getBestInstructionSet();
+
+	// Parameters in processor order with the hash of their ID, for the binary state
+	struct StateParameter
+	{
+		juce::uint32 idHash;
+		juce::RangedAudioParameter* parameter;
+	};
+
+	std::vector<StateParameter> m_stateParameters;
 
-	EnvelopeFollower m_envelopeFollower[2] = {};
-	CrestFactor m_crestFactorCalculator[2] = {};
+	PresetBank m_presets;
+	std::atomic<int> m_currentProgram{ 0 };
 
-#ifdef DEBUG
-	float m_attackTime = 0.0f;
-	float m_releaseTime = 0.0f;
-	float m_crestFactorPercentage = 0.0f;
-	float m_gainReductiondB = 0.0f;
-#endif
+	// Program waiting for the message thread, -1 when none
+	std::atomic<int> m_pendingProgram{ -1 };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CrestCompressorAudioProcessor)
 };
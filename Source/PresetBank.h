@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    Programs of the processor as precomputed snapshots of normalized
+    parameter values, one per parameter in processor order. Snapshots are
+    built once, applying one only writes the parameters that differ, so a
+    program change allocates nothing and parses nothing. Every write
+    notifies the host, which may lock, so programs are applied on the
+    message thread, the processor defers a change made on another thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class PresetBank
+{
+public:
+	// Plain (not normalized) value, choice parameters take the item index
+	struct Value
+	{
+		const char* parameterID;
+		float value;
+	};
+
+	// Not real time safe. Parameters without a value keep their default.
+	void addPreset(const juce::String& name, const juce::Array<juce::AudioProcessorParameter*>& parameters, std::initializer_list<Value> values)
+	{
+		std::vector<float> snapshot;
+		snapshot.reserve((size_t)parameters.size());
+
+		for (auto* parameter : parameters)
+			snapshot.push_back(parameter->getDefaultValue());
+
+		for (const auto& value : values)
+		{
+			for (int i = 0; i < parameters.size(); ++i)
+			{
+				auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameters[i]);
+
+				if (ranged != nullptr && ranged->paramID == value.parameterID)
+					snapshot[(size_t)i] = ranged->convertTo0to1(value.value);
+			}
+		}
+
+		m_names.add(name);
+		m_snapshots.push_back(std::move(snapshot));
+	}
+
+	int getNumPresets() const { return (int)m_snapshots.size(); }
+
+	juce::String getName(int index) const { return m_names[index]; }
+
+	// Not real time safe
+	void setName(int index, const juce::String& name)
+	{
+		if (juce::isPositiveAndBelow(index, m_names.size()))
+			m_names.set(index, name);
+	}
+
+	// Message thread only, hosts are notified of every parameter that changes and may lock
+	void apply(int index, const juce::Array<juce::AudioProcessorParameter*>& parameters) const
+	{
+		JUCE_ASSERT_MESSAGE_THREAD
+
+		if (! juce::isPositiveAndBelow(index, getNumPresets()))
+			return;
+
+		const auto& snapshot = m_snapshots[(size_t)index];
+
+		for (int i = 0; i < juce::jmin(parameters.size(), (int)snapshot.size()); ++i)
+			if (parameters[i]->getValue() != snapshot[(size_t)i])
+				parameters[i]->setValueNotifyingHost(snapshot[(size_t)i]);
+	}
+
+private:
+	juce::StringArray m_names;
+	std::vector<std::vector<float>> m_snapshots;
+};
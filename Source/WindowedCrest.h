@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    WindowedCrest.h
+
+    Squared crest factor over an exact sliding window for any number of
+    channels, alternative to the exponential DetectorBank::processCrestSQ.
+    Peak is the front of a monotonic deque of sample indices (sliding
+    maximum), RMS a running sum of squares. Both are amortized O(1) per
+    sample whatever the window length. Storage for the maximum window is
+    allocated in prepare(), channels are processed one after another.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+//==============================================================================
+template <typename SampleType>
+class WindowedCrest
+{
+public:
+	// Not real time safe
+	void prepare(int channels, int maxWindowSamples)
+	{
+		int capacity = 1;
+		while (capacity < maxWindowSamples)
+			capacity *= 2;
+
+		m_mask = (uint32_t)capacity - 1;
+		m_capacity = capacity;
+		m_window = std::min(std::max(m_window, 1), capacity);
+		m_channels = channels;
+
+		m_squares.assign((size_t)channels * (size_t)capacity, SampleType(0));
+		m_deques.assign((size_t)channels * (size_t)capacity, 0);
+		m_states.assign((size_t)channels, ChannelState());
+	}
+
+	// Channels processed from now on, up to the prepared count, state is reset
+	void setNumChannels(int channels)
+	{
+		m_channels = std::min(channels, (int)m_states.size());
+		reset();
+	}
+
+	// O(1) per channel, history older than the reset is never read
+	void reset()
+	{
+		std::fill(m_states.begin(), m_states.end(), ChannelState());
+	}
+
+	int getNumChannels() const { return m_channels; }
+
+	// Prepared channels and longest window in samples
+	int getMaxChannels() const { return (int)m_states.size(); }
+	int getMaxWindow() const { return m_capacity; }
+
+	// Window in samples, up to the prepared maximum. The history always holds the
+	// prepared maximum, so a new length only moves the start of the window of the
+	// active channels, O(length change) per channel.
+	void setWindow(int samples)
+	{
+		samples = std::min(std::max(samples, 1), m_capacity);
+
+		if (samples == m_window)
+			return;
+
+		for (int channel = 0; channel < m_channels; ++channel)
+			moveWindowStart(channel, (uint32_t)m_window, (uint32_t)samples);
+
+		m_window = samples;
+	}
+
+	int getWindow() const { return m_window; }
+
+	// Squared crest factor (peak^2 / mean square) of in[channel][inStart + i] to out[channel][i],
+	// floored at -200 dB as DetectorBank, samples before the first one count as zero
+	void processCrestSQ(const SampleType* const* in, int inStart, SampleType* const* out, int samples)
+	{
+		const uint32_t window = (uint32_t)m_window;
+		const uint32_t mask = m_mask;
+		const SampleType inverseWindow = SampleType(1) / (SampleType)window;
+		const SampleType silenceSQ = SampleType(1.0e-20);
+
+		for (int channel = 0; channel < m_channels; ++channel)
+		{
+			auto& state = m_states[(size_t)channel];
+			SampleType* squares = m_squares.data() + (size_t)channel * (size_t)m_capacity;
+			uint32_t* deque = m_deques.data() + (size_t)channel * (size_t)m_capacity;
+
+			const SampleType* input = in[channel] + inStart;
+			SampleType* output = out[channel];
+
+			uint32_t position = state.position;
+			uint32_t head = state.head;
+			uint32_t tail = state.tail;
+			uint32_t filled = state.filled;
+			SampleType sum = state.sum;
+			SampleType fresh = state.fresh;
+			uint32_t freshCount = state.freshCount;
+
+			for (int sample = 0; sample < samples; ++sample)
+			{
+				const SampleType inSQ = input[sample] * input[sample];
+
+				// Oldest sample leaves the window, read before its slot can be overwritten
+				if (head != tail && position - deque[head & mask] >= window)
+					++head;
+
+				if (filled >= window)
+					sum -= squares[(position - window) & mask];
+
+				squares[position & mask] = inSQ;
+				sum += inSQ;
+
+				// Smaller values behind the new one can never be the maximum again
+				while (head != tail && squares[deque[(tail - 1) & mask] & mask] <= inSQ)
+					--tail;
+
+				deque[tail & mask] = position;
+				++tail;
+
+				// Drift correction, once a full window has been summed by additions only it replaces the running sum
+				fresh += inSQ;
+				if (++freshCount == window)
+				{
+					sum = fresh;
+					fresh = 0;
+					freshCount = 0;
+				}
+
+				++position;
+				filled = std::min(filled + 1, (uint32_t)m_capacity);
+
+				const SampleType peakSQ = squares[deque[head & mask] & mask];
+				output[sample] = std::max(peakSQ, silenceSQ) / std::max(sum * inverseWindow, silenceSQ);
+			}
+
+			state.position = position;
+			state.head = head;
+			state.tail = tail;
+			state.filled = filled;
+			state.sum = sum;
+			state.fresh = fresh;
+			state.freshCount = freshCount;
+		}
+	}
+
+private:
+	// Deque holds sample positions with decreasing squares, head is the window maximum
+	struct ChannelState
+	{
+		uint32_t position = 0;
+		uint32_t head = 0;
+		uint32_t tail = 0;
+		uint32_t filled = 0;
+		SampleType sum = 0;
+		SampleType fresh = 0;
+		uint32_t freshCount = 0;
+	};
+
+	// Sum and deque of the last newWindow samples from those of the last oldWindow samples.
+	// A shorter window drops the oldest samples, a longer one adds older samples from the
+	// history in front, where they only enter the deque above its current maximum.
+	void moveWindowStart(int channel, uint32_t oldWindow, uint32_t newWindow)
+	{
+		auto& state = m_states[(size_t)channel];
+		const SampleType* squares = m_squares.data() + (size_t)channel * (size_t)m_capacity;
+		uint32_t* deque = m_deques.data() + (size_t)channel * (size_t)m_capacity;
+
+		const uint32_t oldLength = std::min(state.filled, oldWindow);
+		const uint32_t newLength = std::min(state.filled, newWindow);
+
+		for (uint32_t length = oldLength; length > newLength; --length)
+			state.sum -= squares[(state.position - length) & m_mask];
+
+		while (state.head != state.tail && state.position - deque[state.head & m_mask] > newLength)
+			++state.head;
+
+		for (uint32_t length = oldLength + 1; length <= newLength; ++length)
+		{
+			const uint32_t position = state.position - length;
+			const SampleType inSQ = squares[position & m_mask];
+			state.sum += inSQ;
+
+			if (state.head == state.tail || inSQ > squares[deque[state.head & m_mask] & m_mask])
+			{
+				--state.head;
+				deque[state.head & m_mask] = position;
+			}
+		}
+
+		// Drift correction starts over on the new length
+		state.fresh = 0;
+		state.freshCount = 0;
+	}
+
+	std::vector<SampleType> m_squares;
+	std::vector<uint32_t> m_deques;
+	std::vector<ChannelState> m_states;
+
+	uint32_t m_mask = 0;
+	int m_capacity = 1;
+	int m_window = 1;
+	int m_channels = 0;
+};
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    ProcessorSettings.h
+
+    Parameter values for headless CrestCompressorAudioProcessor hosts, given as
+    Name=value pairs on the command line or as lines of a preset text file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+namespace ProcessorSettings
+{
+	// Parameter ID -> value text, applied in insertion order
+	using Values = juce::StringPairArray;
+
+	// "Name=value"
+	inline bool parseAssignment(const juce::String& text, Values& values, juce::String& error)
+	{
+		const auto name = text.upToFirstOccurrenceOf("=", false, false).trim();
+		const auto value = text.fromFirstOccurrenceOf("=", false, false).trim();
+
+		if (name.isEmpty() || value.isEmpty())
+		{
+			error = "Expected Name=value, got '" + text + "'";
+			return false;
+		}
+
+		values.set(name, value);
+		return true;
+	}
+
+	// One Name=value per line, '#' starts a comment
+	inline bool loadPresetFile(const juce::File& file, Values& values, juce::String& error)
+	{
+		if (! file.existsAsFile())
+		{
+			error = "Preset file not found: " + file.getFullPathName();
+			return false;
+		}
+
+		juce::StringArray lines;
+		lines.addLines(file.loadFileAsString());
+
+		for (const auto& line : lines)
+		{
+			const auto text = line.upToFirstOccurrenceOf("#", false, false).trim();
+
+			if (text.isNotEmpty() && ! parseAssignment(text, values, error))
+			{
+				error = file.getFileName() + ": " + error;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Choice parameters accept the item name or its index
+	inline bool apply(CrestCompressorAudioProcessor& processor, const Values& values, juce::String& error)
+	{
+		const auto& names = values.getAllKeys();
+
+		for (int i = 0; i < names.size(); ++i)
+		{
+			auto* parameter = processor.apvts.getParameter(names[i]);
+
+			if (parameter == nullptr)
+			{
+				error = "Unknown parameter: " + names[i];
+				return false;
+			}
+
+			const auto text = values.getAllValues()[i];
+			float value = text.getFloatValue();
+
+			if (auto* choiceParameter = dynamic_cast<juce::AudioParameterChoice*>(parameter))
+			{
+				const int index = choiceParameter->choices.indexOf(text, true);
+				if (index >= 0)
+					value = (float)index;
+			}
+
+			parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,825 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Microbenchmarks for CrestCompressorAudioProcessor::processBlock and the
+    detector classes. Results are printed as CSV, one row per configuration,
+    so runs of different releases can be diffed.
+
+    processBlock is measured in float, in double and with double buffers
+    converted to float and back, the copies a double precision host makes
+    around a plugin without double support.
+
+    processBlock is swept one axis at a time around a default config (noise,
+    2 channels, 48 kHz, 512 sample blocks, best instruction set). --axis
+    <name>, repeatable, sweeps the product of the named axes instead, the
+    others stay at the default.
+
+    Every instruction set build of the kernels the CPU supports is measured,
+    see DspKernels.h. CrestCompressorCore is also measured on its own, over
+    planar channels and over interleaved frames.
+
+    --accuracy prints the fast kernel error against the exact kernel, the
+    control rate error against the per sample gain computer and the error of
+    each instruction set against the scalar kernels on noise, sine and
+    drum-like material instead.
+
+    --check runs assertions instead and exits non-zero when one fails: every
+    parameter the editor attaches to exists, one block processes in float
+    and double at each oversampling factor, the fast kernel stays within
+    0.01 dB of the exact kernel and control rates 8, 16 and 32 within 0.2 dB
+    of the per sample gain computer for attacks of 5 ms and longer.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Common/ProcessorSettings.h"
+#include "../../../Source/PluginEditor.h"
+
+#include <functional>
+#include <iostream>
+
+//==============================================================================
+namespace
+{
+	enum class Input { Silence, Noise, Sine, Transients };
+	enum class Precision { Float, Double, DoubleConverted };
+
+	const char* getInputName(Input input)
+	{
+		switch (input)
+		{
+			case Input::Silence:    return "silence";
+			case Input::Noise:      return "noise";
+			case Input::Sine:       return "sine";
+			case Input::Transients: return "transients";
+		}
+
+		return "";
+	}
+
+	const char* getPrecisionName(Precision precision)
+	{
+		switch (precision)
+		{
+			case Precision::Float:           return "float";
+			case Precision::Double:          return "double";
+			case Precision::DoubleConverted: return "double_converted";
+		}
+
+		return "";
+	}
+
+	// Deterministic test material, same for every run
+	void fillInput(juce::AudioBuffer<float>& buffer, Input input, double sampleRate)
+	{
+		juce::Random random(1234);
+
+		for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+		{
+			auto* data = buffer.getWritePointer(channel);
+
+			for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+			{
+				const double time = sample / sampleRate;
+				const float noise = random.nextFloat() * 2.0f - 1.0f;
+
+				switch (input)
+				{
+					case Input::Silence:
+						data[sample] = 0.0f;
+						break;
+					case Input::Noise:
+						data[sample] = 0.5f * noise;
+						break;
+					case Input::Sine:
+						data[sample] = 0.5f * (float)std::sin(juce::MathConstants<double>::twoPi * 440.0 * time);
+						break;
+					case Input::Transients:
+					{
+						// Decaying bursts every 250 ms, like a drum loop
+						const double hitTime = std::fmod(time, 0.25);
+						data[sample] = 0.9f * noise * (float)std::exp(-hitTime / 0.03) + 0.01f * noise;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	struct Config
+	{
+		Input input = Input::Noise;
+		int channels = 2;
+		double sampleRate = 48000.0;
+		int blockSize = 512;
+		float ratio = -12.0f;
+		float threshold = 25.0f;
+		float smooth = 0.01f;
+		float mix = 1.0f;
+		juce::String kernel = "Exact";
+		juce::String rate = "1";
+		juce::String link = "Off";
+		juce::String oversampling = "1x";
+		DspKernels::InstructionSet instructionSet = DspKernels::InstructionSet::Scalar;
+		Precision precision = Precision::Float;
+	};
+
+	struct Measurement
+	{
+		double nsPerSample = 0.0;
+		double realtimeFactor = 0.0;
+	};
+
+	void printHeader()
+	{
+		std::cout << "target,kernel,rate,link,oversampling,isa,precision,input,channels,sample_rate,block_size,ratio,mix,ns_per_sample,realtime_factor" << std::endl;
+	}
+
+	void printRow(const char* target, const Config& config, const Measurement& measurement)
+	{
+		std::cout << target << ',' << config.kernel << ',' << config.rate << ',' << config.link << ',' << config.oversampling << ',' << DspKernels::getName(config.instructionSet) << ',' << getPrecisionName(config.precision) << ',' << getInputName(config.input) << ',' << config.channels << ','
+		          << config.sampleRate << ',' << config.blockSize << ',' << config.ratio << ',' << config.mix << ','
+		          << measurement.nsPerSample << ',' << measurement.realtimeFactor << std::endl;
+	}
+
+	// processBlock sweep axes, named like the CSV columns
+	juce::StringArray getAxisNames()
+	{
+		return { "precision", "isa", "kernel", "rate", "link", "oversampling", "input", "sample_rate", "channels", "ratio", "mix", "block_size" };
+	}
+
+	// One swept parameter, each value sets one member of a copy of the default config
+	struct Axis
+	{
+		juce::String name;
+		std::vector<std::function<void(Config&)>> values;
+	};
+
+	template <typename Value>
+	Axis makeAxis(const juce::String& name, const std::vector<Value>& values, Value Config::* member)
+	{
+		Axis axis{ name, {} };
+
+		for (const auto& value : values)
+			axis.values.push_back([value, member](Config& config) { config.*member = value; });
+
+		return axis;
+	}
+
+	void applyConfig(CrestCompressorAudioProcessor& processor, const Config& config)
+	{
+		processor.setInstructionSet(config.instructionSet);
+
+		ProcessorSettings::Values values;
+		values.set("Attack", juce::String(config.ratio));
+		values.set("Threshold", juce::String(config.threshold));
+		values.set("Smooth", juce::String(config.smooth));
+		values.set("Mix", juce::String(config.mix));
+		values.set("Kernel", config.kernel);
+		values.set("Rate", config.rate);
+		values.set("Link", config.link);
+		values.set("Oversampling", config.oversampling);
+
+		juce::String error;
+		ProcessorSettings::apply(processor, values, error);
+	}
+
+	// Renders the whole input block by block, returns seconds
+	template <typename SampleType>
+	double renderOnce(CrestCompressorAudioProcessor& processor, juce::AudioBuffer<SampleType>& work, int blockSize)
+	{
+		juce::MidiBuffer midiMessages;
+		const int length = work.getNumSamples();
+
+		const auto startTicks = juce::Time::getHighResolutionTicks();
+
+		for (int start = 0; start < length; start += blockSize)
+		{
+			juce::AudioBuffer<SampleType> block(work.getArrayOfWritePointers(), work.getNumChannels(), start, juce::jmin(blockSize, length - start));
+			processor.processBlock(block, midiMessages);
+		}
+
+		return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+	}
+
+	// Same through the float processBlock, each block is converted into scratch and back
+	template <typename SampleType>
+	double renderConverted(CrestCompressorAudioProcessor& processor, juce::AudioBuffer<SampleType>& work, juce::AudioBuffer<float>& scratch, int blockSize)
+	{
+		juce::MidiBuffer midiMessages;
+		const int length = work.getNumSamples();
+		const int channels = work.getNumChannels();
+
+		const auto startTicks = juce::Time::getHighResolutionTicks();
+
+		for (int start = 0; start < length; start += blockSize)
+		{
+			const int blockSamples = juce::jmin(blockSize, length - start);
+
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				const SampleType* in = work.getReadPointer(channel, start);
+				float* out = scratch.getWritePointer(channel);
+
+				for (int sample = 0; sample < blockSamples; ++sample)
+					out[sample] = (float)in[sample];
+			}
+
+			juce::AudioBuffer<float> block(scratch.getArrayOfWritePointers(), channels, blockSamples);
+			processor.processBlock(block, midiMessages);
+
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				const float* in = scratch.getReadPointer(channel);
+				SampleType* out = work.getWritePointer(channel, start);
+
+				for (int sample = 0; sample < blockSamples; ++sample)
+					out[sample] = (SampleType)in[sample];
+			}
+		}
+
+		return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+	}
+
+	// Best of several repetitions, the input is restored before each one
+	template <typename SampleType>
+	Measurement measureProcessBlockAs(const Config& config, double seconds, int repetitions)
+	{
+		const int length = (int)(seconds * config.sampleRate);
+		const bool converted = config.precision == Precision::DoubleConverted;
+
+		juce::AudioBuffer<float> source(config.channels, length);
+		fillInput(source, config.input, config.sampleRate);
+
+		juce::AudioBuffer<SampleType> input;
+		juce::AudioBuffer<SampleType> work(config.channels, length);
+		juce::AudioBuffer<float> scratch(config.channels, config.blockSize);
+		input.makeCopyOf(source);
+
+		CrestCompressorAudioProcessor processor;
+		applyConfig(processor, config);
+		processor.setNonRealtime(true);
+		processor.setProcessingPrecision(config.precision == Precision::Double ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+		processor.setPlayConfigDetails(config.channels, config.channels, config.sampleRate, config.blockSize);
+		processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+		double best = std::numeric_limits<double>::max();
+
+		// First repetition warms caches and is not counted
+		for (int repetition = 0; repetition <= repetitions; ++repetition)
+		{
+			work.makeCopyOf(input, true);
+			const double elapsed = converted ? renderConverted(processor, work, scratch, config.blockSize)
+			                                 : renderOnce(processor, work, config.blockSize);
+
+			if (repetition > 0)
+				best = juce::jmin(best, elapsed);
+		}
+
+		Measurement measurement;
+		measurement.nsPerSample = best * 1.0e9 / ((double)length * config.channels);
+		measurement.realtimeFactor = seconds / best;
+		return measurement;
+	}
+
+	Measurement measureProcessBlock(const Config& config, double seconds, int repetitions)
+	{
+		if (config.precision == Precision::Float)
+			return measureProcessBlockAs<float>(config, seconds, repetitions);
+
+		return measureProcessBlockAs<double>(config, seconds, repetitions);
+	}
+
+	// Product of the axes from axisIndex on, one processBlock row per combination
+	void sweep(const Config& config, const std::vector<const Axis*>& axes, size_t axisIndex, double seconds, int repetitions)
+	{
+		if (axisIndex == axes.size())
+		{
+			printRow("processBlock", config, measureProcessBlock(config, seconds, repetitions));
+			return;
+		}
+
+		for (const auto& setValue : axes[axisIndex]->values)
+		{
+			Config swept = config;
+			setValue(swept);
+			sweep(swept, axes, axisIndex + 1, seconds, repetitions);
+		}
+	}
+
+	// The JUCE independent core on its own, in place over planar channels or interleaved frames, as another host calls it
+	template <typename SampleType>
+	Measurement measureCore(const Config& config, double seconds, int repetitions, bool interleaved)
+	{
+		const int length = (int)(seconds * config.sampleRate);
+		const int channels = config.channels;
+
+		juce::AudioBuffer<float> source(channels, length);
+		fillInput(source, config.input, config.sampleRate);
+
+		juce::AudioBuffer<SampleType> input;
+		juce::AudioBuffer<SampleType> work(channels, length);
+		input.makeCopyOf(source);
+
+		std::vector<SampleType> frames((size_t)length * (size_t)channels);
+		std::vector<SampleType*> rows((size_t)channels);
+
+		const juce::StringArray links{ "Off", "Max", "Power", "Mid" };
+
+		CrestCompressorParameters parameters;
+		parameters.ratio[0] = config.ratio;
+		parameters.mix = config.mix;
+		parameters.kernel = (config.kernel == "Fast") ? CrestCompressorParameters::Kernel::Fast : CrestCompressorParameters::Kernel::Exact;
+		parameters.controlInterval = config.rate.getIntValue();
+		parameters.link = (CrestCompressorParameters::Link)juce::jmax(0, links.indexOf(config.link));
+		parameters.oversampling = config.oversampling.getIntValue();
+
+		CrestCompressorCore<SampleType> core;
+		core.prepare(channels, config.sampleRate, parameters, config.instructionSet);
+
+		double best = std::numeric_limits<double>::max();
+
+		for (int repetition = 0; repetition <= repetitions; ++repetition)
+		{
+			work.makeCopyOf(input, true);
+
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				const SampleType* in = input.getReadPointer(channel);
+
+				for (int sample = 0; sample < length; ++sample)
+					frames[(size_t)sample * (size_t)channels + (size_t)channel] = in[sample];
+			}
+
+			const auto startTicks = juce::Time::getHighResolutionTicks();
+
+			for (int start = 0; start < length; start += config.blockSize)
+			{
+				const int blockSamples = juce::jmin(config.blockSize, length - start);
+
+				if (interleaved)
+				{
+					core.processInterleaved(frames.data() + (size_t)start * (size_t)channels, channels, blockSamples);
+				}
+				else
+				{
+					for (int channel = 0; channel < channels; ++channel)
+						rows[(size_t)channel] = work.getWritePointer(channel, start);
+
+					core.process(rows.data(), channels, blockSamples);
+				}
+			}
+
+			const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+			if (repetition > 0)
+				best = juce::jmin(best, elapsed);
+		}
+
+		Measurement measurement;
+		measurement.nsPerSample = best * 1.0e9 / ((double)length * channels);
+		measurement.realtimeFactor = seconds / best;
+		return measurement;
+	}
+
+	// Per sample detector calls, single channel
+	template <typename SampleType, typename Process>
+	Measurement measureDetector(const Config& config, double seconds, int repetitions, Process&& process)
+	{
+		const int length = (int)(seconds * config.sampleRate);
+
+		juce::AudioBuffer<float> source(1, length);
+		fillInput(source, config.input, config.sampleRate);
+
+		juce::AudioBuffer<SampleType> input;
+		input.makeCopyOf(source);
+		const SampleType* data = input.getReadPointer(0);
+
+		double best = std::numeric_limits<double>::max();
+		SampleType sink = 0;
+
+		for (int repetition = 0; repetition <= repetitions; ++repetition)
+		{
+			const auto startTicks = juce::Time::getHighResolutionTicks();
+
+			for (int sample = 0; sample < length; ++sample)
+				sink += process(data[sample]);
+
+			const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+			if (repetition > 0)
+				best = juce::jmin(best, elapsed);
+		}
+
+		// Keep the result alive
+		if (sink == SampleType(1.2345))
+			std::cerr << sink;
+
+		Measurement measurement;
+		measurement.nsPerSample = best * 1.0e9 / (double)length;
+		measurement.realtimeFactor = seconds / best;
+		return measurement;
+	}
+
+	template <typename SampleType>
+	void measureDetectors(const Config& config, double seconds, int repetitions)
+	{
+		CrestFactor<SampleType> crestFactor;
+		crestFactor.init((int)config.sampleRate);
+		crestFactor.setCoef(SampleType(0.1));
+		printRow("CrestFactor::process", config, measureDetector<SampleType>(config, seconds, repetitions, [&crestFactor](SampleType in) { return crestFactor.process(in); }));
+
+		EnvelopeFollower<SampleType> envelopeFollower;
+		envelopeFollower.init((int)config.sampleRate);
+		envelopeFollower.setCoef(SampleType(1), SampleType(100));
+		printRow("EnvelopeFollower::process", config, measureDetector<SampleType>(config, seconds, repetitions, [&envelopeFollower](SampleType in) { return envelopeFollower.process(in); }));
+
+		// Sliding window, cost must not grow with the window length
+		for (auto windowMs : { 10, 100, 500 })
+		{
+			WindowedCrest<SampleType> windowedCrest;
+			windowedCrest.prepare(1, (int)std::ceil(CrestCompressorAudioProcessor::WINDOW_LIMIT_MS * 0.001 * config.sampleRate));
+			windowedCrest.setWindow((int)(windowMs * 0.001 * config.sampleRate));
+
+			const juce::String target = "WindowedCrest::processCrestSQ " + juce::String(windowMs) + "ms";
+			printRow(target.toRawUTF8(), config, measureDetector<SampleType>(config, seconds, repetitions, [&windowedCrest](SampleType in)
+			{
+				const SampleType* input = &in;
+				SampleType output = 0;
+				SampleType* outputs = &output;
+				windowedCrest.processCrestSQ(&input, 0, &outputs, 1);
+				return output;
+			}));
+		}
+	}
+
+	// Maximum output difference in dB of a configuration against a reference configuration,
+	// e.g. the fast against the exact kernel or a control rate against the per sample gain
+	// The first skipSeconds are rendered but not compared, e.g. while the detectors settle
+	double measureOutputError(const Config& reference, const Config& test, double seconds, double skipSeconds = 0.0)
+	{
+		const int length = (int)(seconds * reference.sampleRate);
+
+		juce::AudioBuffer<float> input(reference.channels, length);
+		fillInput(input, reference.input, reference.sampleRate);
+
+		juce::AudioBuffer<float> outputs[2];
+		const Config* configs[2] = { &reference, &test };
+
+		for (int i = 0; i < 2; ++i)
+		{
+			const Config& config = *configs[i];
+
+			CrestCompressorAudioProcessor processor;
+			applyConfig(processor, config);
+			processor.setNonRealtime(true);
+			processor.setPlayConfigDetails(config.channels, config.channels, config.sampleRate, config.blockSize);
+			processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+			outputs[i].makeCopyOf(input, true);
+			renderOnce(processor, outputs[i], config.blockSize);
+		}
+
+		double maxErrordB = 0.0;
+
+		for (int channel = 0; channel < reference.channels; ++channel)
+		{
+			const float* expected = outputs[0].getReadPointer(channel);
+			const float* actual = outputs[1].getReadPointer(channel);
+
+			// Gain difference, skip samples close to zero crossings
+			for (int sample = (int)(skipSeconds * reference.sampleRate); sample < length; ++sample)
+				if (std::abs(expected[sample]) > 1.0e-4f)
+					maxErrordB = juce::jmax(maxErrordB, std::abs(20.0 * std::log10((double)actual[sample] / (double)expected[sample])));
+		}
+
+		return maxErrordB;
+	}
+
+	//==============================================================================
+	// --check: assertions, each failure is printed and makes the exit code non-zero
+	struct CheckResult
+	{
+		int failures = 0;
+
+		void expect(bool condition, const juce::String& what)
+		{
+			std::cout << (condition ? "PASS " : "FAIL ") << what << std::endl;
+
+			if (! condition)
+				++failures;
+		}
+	};
+
+	// Every declared parameter exists, and the processor runs one block per Oversampling choice in both precisions
+	template <typename SampleType>
+	void checkProcessorBlock(CheckResult& result, const juce::String& oversampling, int expectedLatency)
+	{
+		Config config;
+		config.oversampling = oversampling;
+		config.precision = std::is_same<SampleType, double>::value ? Precision::Double : Precision::Float;
+
+		CrestCompressorAudioProcessor processor;
+		applyConfig(processor, config);
+		processor.setProcessingPrecision(config.precision == Precision::Double ? juce::AudioProcessor::doublePrecision : juce::AudioProcessor::singlePrecision);
+		processor.setPlayConfigDetails(config.channels, config.channels, config.sampleRate, config.blockSize);
+		processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+		juce::AudioBuffer<float> source(config.channels, config.blockSize);
+		fillInput(source, Input::Noise, config.sampleRate);
+
+		juce::AudioBuffer<SampleType> buffer;
+		buffer.makeCopyOf(source);
+
+		juce::MidiBuffer midiMessages;
+		processor.processBlock(buffer, midiMessages);
+
+		bool finite = true;
+
+		for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+		{
+			const SampleType* data = buffer.getReadPointer(channel);
+
+			for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+				finite = finite && std::isfinite((double)data[sample]);
+		}
+
+		const juce::String what = "processBlock " + juce::String(getPrecisionName(config.precision)) + " Oversampling=" + oversampling;
+		result.expect(finite, what + " output finite");
+		result.expect(processor.getLatencySamples() == expectedLatency, what + " latency " + juce::String(processor.getLatencySamples()));
+	}
+
+	void checkProcessor(CheckResult& result)
+	{
+		CrestCompressorAudioProcessor processor;
+
+		// Each name the editor attaches a control to
+		using Editor = CrestCompressorAudioProcessorEditor;
+		const std::pair<const std::string*, int> nameLists[] = { { CrestCompressorAudioProcessor::paramsNames, Editor::N_SLIDERS_COUNT },
+		                                                         { CrestCompressorAudioProcessor::bandParamsNames, Editor::N_BAND_SLIDERS_COUNT },
+		                                                         { CrestCompressorAudioProcessor::choiceNames, Editor::N_CHOICES_COUNT } };
+
+		for (const auto& names : nameLists)
+			for (int i = 0; i < names.second; ++i)
+				result.expect(processor.apvts.getParameter(names.first[i]) != nullptr, "parameter " + juce::String(names.first[i]));
+
+		const std::pair<const char*, int> oversamplings[] = { { "1x", 0 }, { "2x", 31 }, { "4x", 36 } };
+
+		for (const auto& oversampling : oversamplings)
+		{
+			checkProcessorBlock<float>(result, oversampling.first, oversampling.second);
+			checkProcessorBlock<double>(result, oversampling.first, oversampling.second);
+		}
+	}
+
+	// Fast kernel output against the exact kernel, bound of FastMath.h with margin
+	static constexpr double FAST_KERNEL_LIMIT_DB = 0.01;
+
+	// Threshold 5 attenuates all test material, at the default 25 only the transients reach the threshold
+	const float CHECK_THRESHOLDS[] = { 5.0f, 25.0f };
+
+	void checkFastKernel(CheckResult& result, double seconds)
+	{
+		for (auto input : { Input::Noise, Input::Sine, Input::Transients })
+			for (auto threshold : CHECK_THRESHOLDS)
+				for (auto ratio : { -24.0f, -12.0f, -3.0f, 3.0f, 12.0f, 24.0f })
+					for (const char* rate : { "1", "16" })
+					{
+						Config reference;
+						reference.input = input;
+						reference.threshold = threshold;
+						reference.ratio = ratio;
+						reference.rate = rate;
+
+						Config fast = reference;
+						fast.kernel = "Fast";
+
+						const double error = measureOutputError(reference, fast, seconds);
+						result.expect(error <= FAST_KERNEL_LIMIT_DB, juce::String("fast kernel ") + getInputName(input) + " threshold " + juce::String(threshold) + " ratio " + juce::String(ratio)
+						                                             + " rate " + rate + ": " + juce::String(error, 5) + " dB <= " + juce::String(FAST_KERNEL_LIMIT_DB) + " dB");
+					}
+	}
+
+	// Control rates against the per sample gain computer, bound of the Rate parameter in README.md.
+	// Faster attacks lag transients by up to one interval and are not covered.
+	static constexpr double CONTROL_RATE_LIMIT_DB = 0.2;
+	static constexpr double CONTROL_RATE_SETTLE_SECONDS = 1.0;
+
+	void checkControlRate(CheckResult& result, double seconds)
+	{
+		// Smooth is the expand attack, compression attacks 200 - Smooth, so both are 5 ms or longer
+		for (auto input : { Input::Noise, Input::Sine, Input::Transients })
+			for (auto threshold : CHECK_THRESHOLDS)
+				for (auto smooth : { 5.0f, 195.0f })
+					for (auto ratio : { -24.0f, -3.0f, 3.0f, 24.0f })
+					{
+						Config reference;
+						reference.input = input;
+						reference.threshold = threshold;
+						reference.smooth = smooth;
+						reference.ratio = ratio;
+
+						for (const char* rate : { "8", "16", "32" })
+						{
+							Config control = reference;
+							control.rate = rate;
+
+							const double error = measureOutputError(reference, control, CONTROL_RATE_SETTLE_SECONDS + seconds, CONTROL_RATE_SETTLE_SECONDS);
+							result.expect(error <= CONTROL_RATE_LIMIT_DB, juce::String("rate ") + rate + ' ' + getInputName(input) + " threshold " + juce::String(threshold) + " smooth " + juce::String(smooth)
+							                                              + " ratio " + juce::String(ratio) + ": " + juce::String(error, 5) + " dB <= " + juce::String(CONTROL_RATE_LIMIT_DB) + " dB");
+						}
+					}
+	}
+
+	int runChecks(double seconds)
+	{
+		CheckResult result;
+		checkProcessor(result);
+		checkFastKernel(result, seconds);
+		checkControlRate(result, seconds);
+
+		std::cout << (result.failures == 0 ? "All checks passed" : juce::String(result.failures) + " checks failed") << std::endl;
+		return result.failures == 0 ? 0 : 1;
+	}
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	// Message manager for the processor's parameter tree
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	double seconds = 2.0;
+	int repetitions = 5;
+	bool quick = false;
+	bool accuracy = false;
+	bool check = false;
+	juce::StringArray axisNames;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const juce::String arg(argv[i]);
+
+		if (arg == "--seconds" && i + 1 < argc)
+			seconds = juce::jmax(0.01, juce::String(argv[++i]).getDoubleValue());
+		else if (arg == "--repetitions" && i + 1 < argc)
+			repetitions = juce::jmax(1, juce::String(argv[++i]).getIntValue());
+		else if (arg == "--quick")
+			quick = true;
+		else if (arg == "--accuracy")
+			accuracy = true;
+		else if (arg == "--check")
+			check = true;
+		else if (arg == "--axis" && i + 1 < argc && getAxisNames().contains(argv[i + 1]))
+			axisNames.addIfNotAlreadyThere(argv[++i]);
+		else
+		{
+			std::cerr << "Usage: CrestBenchmark [--seconds <s>] [--repetitions <n>] [--quick] [--accuracy] [--check] [--axis <name>]..." << std::endl;
+			std::cerr << "Axes: " << getAxisNames().joinIntoString(", ") << std::endl;
+			return 1;
+		}
+	}
+
+	if (check)
+		return runChecks(seconds);
+
+	// Instruction sets the CPU runs, Scalar first
+	std::vector<DspKernels::InstructionSet> instructionSets;
+
+	for (int instructionSet = 0; instructionSet <= (int)DspKernels::getBestInstructionSet(); ++instructionSet)
+		instructionSets.push_back((DspKernels::InstructionSet)instructionSet);
+
+	// Fast kernel against the exact kernel, control rates against the per sample gain computer and
+	// instruction sets against scalar, maximum output difference in dB
+	if (accuracy)
+	{
+		std::cout << "target,input,threshold,ratio,max_error_db" << std::endl;
+
+		for (auto input : { Input::Noise, Input::Sine, Input::Transients })
+			for (auto threshold : CHECK_THRESHOLDS)
+				for (auto ratio : { -24.0f, -12.0f, 12.0f, 24.0f })
+				{
+					Config reference;
+					reference.input = input;
+					reference.threshold = threshold;
+					reference.ratio = ratio;
+
+					const juce::String row = juce::String(",") + getInputName(input) + ',' + juce::String(threshold) + ',' + juce::String(ratio) + ',';
+
+					Config fast = reference;
+					fast.kernel = "Fast";
+					std::cout << "kernel_error" << row << measureOutputError(reference, fast, seconds) << std::endl;
+
+					for (const char* rate : { "8", "16", "32" })
+					{
+						Config control = reference;
+						control.rate = rate;
+						std::cout << "rate_" << rate << "_error" << row << measureOutputError(reference, control, CONTROL_RATE_SETTLE_SECONDS + seconds, CONTROL_RATE_SETTLE_SECONDS) << std::endl;
+					}
+
+					for (size_t i = 1; i < instructionSets.size(); ++i)
+					{
+						Config isa = reference;
+						isa.instructionSet = instructionSets[i];
+						std::cout << "isa_" << DspKernels::getName(isa.instructionSet) << "_error" << row << measureOutputError(reference, isa, seconds) << std::endl;
+					}
+				}
+
+		return 0;
+	}
+
+	const std::vector<int> blockSizes = quick ? std::vector<int>{ 64, 512 } : std::vector<int>{ 1, 16, 64, 256, 512, 1024, 4096 };
+	const std::vector<double> sampleRates = quick ? std::vector<double>{ 48000.0 } : std::vector<double>{ 44100.0, 48000.0, 96000.0, 192000.0 };
+	const std::vector<int> channelCounts = quick ? std::vector<int>{ 2, 12 } : std::vector<int>{ 1, 2, 6, 8, 12, 16 };
+	const std::vector<float> ratios = { -12.0f, 12.0f };
+	const std::vector<float> mixes = { 1.0f, 0.5f };
+	const std::vector<Input> inputs = { Input::Silence, Input::Noise, Input::Transients };
+	const std::vector<juce::String> kernels = { "Exact", "Fast" };
+	const std::vector<juce::String> rates = quick ? std::vector<juce::String>{ "1", "16" } : std::vector<juce::String>{ "1", "8", "16", "32" };
+	const std::vector<juce::String> links = quick ? std::vector<juce::String>{ "Off", "Power" } : std::vector<juce::String>{ "Off", "Max", "Power", "Mid" };
+	const std::vector<juce::String> oversamplings = quick ? std::vector<juce::String>{ "1x", "2x" } : std::vector<juce::String>{ "1x", "2x", "4x" };
+	const std::vector<Precision> precisions = { Precision::Float, Precision::Double, Precision::DoubleConverted };
+
+	// Quick compares scalar with the best set only
+	if (quick && instructionSets.size() > 2)
+		instructionSets.erase(instructionSets.begin() + 1, instructionSets.end() - 1);
+
+	printHeader();
+
+	// Detector classes on their own
+	for (auto input : inputs)
+	{
+		Config config;
+		config.input = input;
+		config.channels = 1;
+		config.blockSize = 1;
+		config.kernel = "";
+
+		config.precision = Precision::Float;
+		measureDetectors<float>(config, seconds, repetitions);
+
+		config.precision = Precision::Double;
+		measureDetectors<double>(config, seconds, repetitions);
+	}
+
+	// Core without the plugin wrapper, planar and interleaved, default settings
+	for (auto precision : { Precision::Float, Precision::Double })
+		for (auto input : inputs)
+			for (auto channels : channelCounts)
+				for (auto blockSize : blockSizes)
+				{
+					Config config;
+					config.input = input;
+					config.channels = channels;
+					config.blockSize = blockSize;
+					config.instructionSet = instructionSets.back();
+					config.precision = precision;
+
+					for (bool interleaved : { false, true })
+					{
+						const char* target = interleaved ? "CrestCompressorCore::processInterleaved" : "CrestCompressorCore::process";
+						printRow(target, config, precision == Precision::Float ? measureCore<float>(config, seconds, repetitions, interleaved)
+						                                                      : measureCore<double>(config, seconds, repetitions, interleaved));
+					}
+				}
+
+	// processBlock, each axis on its own around the default config, or the product of the axes given with --axis
+	std::vector<Axis> axes;
+	axes.push_back(makeAxis("precision", precisions, &Config::precision));
+	axes.push_back(makeAxis("isa", instructionSets, &Config::instructionSet));
+	axes.push_back(makeAxis("kernel", kernels, &Config::kernel));
+	axes.push_back(makeAxis("rate", rates, &Config::rate));
+	axes.push_back(makeAxis("link", links, &Config::link));
+	axes.push_back(makeAxis("oversampling", oversamplings, &Config::oversampling));
+	axes.push_back(makeAxis("input", inputs, &Config::input));
+	axes.push_back(makeAxis("sample_rate", sampleRates, &Config::sampleRate));
+	axes.push_back(makeAxis("channels", channelCounts, &Config::channels));
+	axes.push_back(makeAxis("ratio", ratios, &Config::ratio));
+	axes.push_back(makeAxis("mix", mixes, &Config::mix));
+	axes.push_back(makeAxis("block_size", blockSizes, &Config::blockSize));
+
+	Config defaultConfig;
+	defaultConfig.instructionSet = instructionSets.back();
+
+	if (axisNames.isEmpty())
+	{
+		for (const auto& axis : axes)
+			sweep(defaultConfig, { &axis }, 0, seconds, repetitions);
+	}
+	else
+	{
+		std::vector<const Axis*> selected;
+
+		for (const auto& name : axisNames)
+			for (const auto& axis : axes)
+				if (axis.name == name)
+					selected.push_back(&axis);
+
+		sweep(defaultConfig, selected, 0, seconds, repetitions);
+	}
+
+	return 0;
+}
@@ -0,0 +1,483 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchRenderer.h"
+
+#include <iostream>
+#include <thread>
+
+//==============================================================================
+BatchRenderer::BatchRenderer(const Options& options)
+	: m_options(options)
+{
+	// WAV, AIFF, FLAC, Ogg
+	m_formatManager.registerBasicFormats();
+}
+
+int BatchRenderer::render(const juce::Array<juce::File>& inputFiles)
+{
+	m_jobs.clear();
+	m_work.clear();
+	m_nextWork = 0;
+	m_profileStats = {};
+
+	// Plan all files up front, segments of one file are spread over the workers
+	for (const auto& inputFile : inputFiles)
+	{
+		m_jobs.push_back(createJob(inputFile));
+		auto& job = *m_jobs.back();
+
+		if (job.result.error.isNotEmpty())
+		{
+			printResult(job.inputFile, job.result, 0);
+			continue;
+		}
+
+		for (int segment = 0; segment < job.segments; ++segment)
+			m_work.push_back({ (int)m_jobs.size() - 1, segment });
+	}
+
+	const int numWorkers = juce::jlimit(1, juce::jmax(1, (int)m_work.size()), m_options.numWorkers);
+
+	const auto startTicks = juce::Time::getHighResolutionTicks();
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < numWorkers; ++i)
+		workers.emplace_back([this] { runWorker(); });
+
+	for (auto& worker : workers)
+		worker.join();
+
+	const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+	// Summary
+	int failed = 0;
+	double audioSeconds = 0.0;
+
+	for (const auto& job : m_jobs)
+	{
+		if (job->result.ok)
+			audioSeconds += job->result.audioSeconds;
+		else
+			failed++;
+	}
+
+	const int rendered = inputFiles.size() - failed;
+
+	std::cout << "Rendered " << rendered << " of " << inputFiles.size() << " files in " << m_work.size() << " parts with " << numWorkers << " workers in " << wallSeconds << " s" << std::endl;
+	std::cout << "Kernels: " << DspKernels::getName(DspKernels::getBestInstructionSet()) << std::endl;
+
+	if (wallSeconds > 0.0)
+	{
+		std::cout << "Throughput: " << rendered / wallSeconds << " files/s" << std::endl;
+		std::cout << "Realtime factor: " << audioSeconds / wallSeconds << "x" << std::endl;
+	}
+
+	if (m_options.profile)
+		printProfile();
+
+	return failed;
+}
+
+std::unique_ptr<BatchRenderer::FileJob> BatchRenderer::createJob(const juce::File& inputFile)
+{
+	auto job = std::make_unique<FileJob>();
+	job->inputFile = inputFile;
+
+	std::unique_ptr<juce::AudioFormatReader> reader(m_formatManager.createReaderFor(inputFile));
+
+	if (reader == nullptr)
+	{
+		job->result.error = "Unsupported or unreadable file";
+		return job;
+	}
+
+	job->sampleRate = reader->sampleRate;
+	job->channels = (int)reader->numChannels;
+	job->bitsPerSample = (int)reader->bitsPerSample;
+	job->metadata = reader->metadataValues;
+	job->length = reader->lengthInSamples;
+
+	if (job->channels < 1)
+	{
+		job->result.error = "File has no channels";
+		return job;
+	}
+
+	// Output keeps file name and format
+	job->outputFile = m_options.outputDirectory.getChildFile(inputFile.getFileName());
+
+	if (job->outputFile == inputFile || m_formatManager.findFormatForFileExtension(job->outputFile.getFileExtension()) == nullptr)
+	{
+		job->result.error = "Invalid output file " + job->outputFile.getFullPathName();
+		return job;
+	}
+
+	// Segments start on block boundaries, blocks and control intervals line up with a whole file render
+	const juce::int64 blockSize = m_options.blockSize;
+	const juce::int64 segmentLength = (juce::int64)(m_options.segmentSeconds * job->sampleRate) / blockSize * blockSize;
+
+	// Shorter files are not worth the pre-roll
+	if (segmentLength > 0 && job->length > 2 * segmentLength)
+	{
+		job->segmentLength = segmentLength;
+		job->segments = (int)((job->length + segmentLength - 1) / segmentLength);
+	}
+	else
+	{
+		job->segmentLength = job->length;
+		job->segments = 1;
+	}
+
+	job->result.audioSeconds = (double)job->length / job->sampleRate;
+
+	return job;
+}
+
+void BatchRenderer::runWorker()
+{
+	// Own processor per worker, state is reset by prepareToPlay for every file and segment
+	auto processor = std::make_unique<CrestCompressorAudioProcessor>();
+
+	juce::String error;
+	const bool parametersOk = ProcessorSettings::apply(*processor, m_options.parameters, error);
+
+	auto& profiler = processor->getProfiler();
+	profiler.setBudgetFraction(m_options.profileBudget);
+	profiler.setEnabled(m_options.profile);
+
+	// Reader is kept while consecutive items come from the same file
+	std::unique_ptr<juce::AudioFormatReader> reader;
+	int readerJob = -1;
+
+	for (int index = m_nextWork++; index < (int)m_work.size(); index = m_nextWork++)
+	{
+		const auto item = m_work[(size_t)index];
+		auto& job = *m_jobs[(size_t)item.job];
+
+		// Another segment failed, the file is incomplete anyway
+		{
+			const juce::ScopedLock lock(job.lock);
+
+			if (job.failed)
+			{
+				if (settle(job, 1))
+					finishJob(job);
+
+				continue;
+			}
+		}
+
+		bool ok = parametersOk;
+
+		if (ok && readerJob != item.job)
+		{
+			reader.reset(m_formatManager.createReaderFor(job.inputFile));
+			readerJob = item.job;
+
+			if (reader == nullptr)
+			{
+				error = "Unsupported or unreadable file";
+				ok = false;
+			}
+		}
+
+		if (ok)
+		{
+			if (job.segments == 1)
+				ok = renderWholeFile(*processor, *reader, job, error);
+			else
+				renderSegment(*processor, *reader, job, item.segment);
+		}
+
+		if (! ok)
+			failSegment(job, error);
+	}
+
+	if (m_options.profile)
+	{
+		const juce::ScopedLock lock(m_printLock);
+		m_profileStats.merge(profiler.getStats());
+	}
+}
+
+bool BatchRenderer::renderWholeFile(CrestCompressorAudioProcessor& processor, juce::AudioFormatReader& reader, FileJob& job, juce::String& error)
+{
+	// Only worker of this file, streams straight to the writer
+	if (! openWriter(job, error))
+		return false;
+
+	const auto sink = [&job, &error](const juce::AudioBuffer<float>& block, int start, int samples, juce::int64)
+	{
+		if (job.writer->writeFromAudioSampleBuffer(block, start, samples))
+			return true;
+
+		error = "Write failed";
+		return false;
+	};
+
+	if (! renderRange(processor, reader, job, 0, job.length, 0, sink))
+		return false;
+
+	const juce::ScopedLock lock(job.lock);
+
+	if (settle(job, 1))
+		finishJob(job);
+
+	return true;
+}
+
+void BatchRenderer::renderSegment(CrestCompressorAudioProcessor& processor, juce::AudioFormatReader& reader, FileJob& job, int segment)
+{
+	const juce::int64 first = segment * job.segmentLength;
+	const int count = (int)juce::jmin(job.segmentLength, job.length - first);
+	const juce::int64 preroll = (juce::int64)(m_options.prerollSeconds * job.sampleRate);
+
+	// Kept until it is next in order
+	juce::AudioBuffer<float> output(job.channels, count);
+
+	const auto sink = [&output, first](const juce::AudioBuffer<float>& block, int start, int samples, juce::int64 position)
+	{
+		for (int channel = 0; channel < output.getNumChannels(); ++channel)
+			output.copyFrom(channel, (int)(position - first), block, channel, start, samples);
+
+		return true;
+	};
+
+	renderRange(processor, reader, job, first, count, preroll, sink);
+	submitSegment(job, segment, std::move(output));
+}
+
+bool BatchRenderer::renderRange(CrestCompressorAudioProcessor& processor, juce::AudioFormatReader& reader, FileJob& job,
+                                juce::int64 first, juce::int64 count, juce::int64 prerollSamples, const BlockSink& sink)
+{
+	const int channels = job.channels;
+	const int blockSize = m_options.blockSize;
+
+	const auto startTicks = juce::Time::getHighResolutionTicks();
+
+	processor.setNonRealtime(true);
+	processor.setPlayConfigDetails(channels, channels, job.sampleRate, blockSize);
+	processor.prepareToPlay(job.sampleRate, blockSize);
+
+	juce::AudioBuffer<float> buffer(channels, blockSize);
+	juce::MidiBuffer midiMessages;
+
+	// Lookahead delays the output, output sample n leaves the processor at input position n + latency.
+	// The tail is flushed by the reader padding with zeros.
+	const juce::int64 latency = processor.getLatencySamples();
+	const juce::int64 renderLength = job.length + latency;
+
+	// Input position n is processed at reader position n, so the pre-roll starts before first, not before
+	// first + latency. Starts on a block boundary of the whole file render, ends with the block holding the
+	// last output sample.
+	const juce::int64 renderStart = juce::jmax((juce::int64)0, (first - prerollSamples) / blockSize * blockSize);
+	const juce::int64 renderEnd = juce::jmin(renderLength, first + count + latency);
+
+	for (juce::int64 position = renderStart; position < renderEnd; position += blockSize)
+	{
+		const int samples = (int)juce::jmin((juce::int64)blockSize, renderLength - position);
+
+		// Last block is shorter, keep the allocation
+		buffer.setSize(channels, samples, false, false, true);
+
+		reader.read(&buffer, 0, samples, position, true, true);
+		processor.processBlock(buffer, midiMessages);
+
+		// Pre-roll and lookahead output is discarded, so is anything after the range
+		const juce::int64 outputPosition = position - latency;
+		const int skip = (int)juce::jlimit((juce::int64)0, (juce::int64)samples, first - outputPosition);
+		const int end = (int)juce::jlimit((juce::int64)0, (juce::int64)samples, first + count - outputPosition);
+
+		if (end > skip && ! sink(buffer, skip, end - skip, outputPosition + skip))
+			return false;
+	}
+
+	processor.releaseResources();
+
+	// Summed over the workers of the file
+	const double renderSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+	const juce::ScopedLock lock(job.lock);
+	job.result.renderSeconds += renderSeconds;
+
+	return true;
+}
+
+void BatchRenderer::submitSegment(FileJob& job, int segment, juce::AudioBuffer<float>&& buffer)
+{
+	{
+		const juce::ScopedLock lock(job.lock);
+
+		// Another segment failed, the output is incomplete anyway
+		if (job.failed)
+		{
+			if (settle(job, 1))
+				finishJob(job);
+
+			return;
+		}
+
+		job.pending.emplace(segment, std::move(buffer));
+
+		// The thread already writing picks this one up
+		if (job.writing)
+			return;
+
+		job.writing = true;
+	}
+
+	// Writes every segment that is next in order, the writer is used outside the lock
+	for (;;)
+	{
+		juce::AudioBuffer<float> next;
+
+		{
+			const juce::ScopedLock lock(job.lock);
+			auto it = job.pending.find(job.nextSegment);
+
+			// Cleared under the lock submitting threads check, no segment is left behind
+			if (job.failed || it == job.pending.end())
+			{
+				job.writing = false;
+				return;
+			}
+
+			next = std::move(it->second);
+			job.pending.erase(it);
+		}
+
+		juce::String error;
+		const bool ok = (job.writer != nullptr || openWriter(job, error)) && job.writer->writeFromAudioSampleBuffer(next, 0, next.getNumSamples());
+
+		const juce::ScopedLock lock(job.lock);
+
+		if (! ok)
+		{
+			job.writing = false;
+
+			if (fail(job, error.isNotEmpty() ? error : juce::String("Write failed")))
+				finishJob(job);
+
+			return;
+		}
+
+		job.nextSegment++;
+
+		if (settle(job, 1))
+		{
+			job.writing = false;
+			finishJob(job);
+			return;
+		}
+	}
+}
+
+void BatchRenderer::failSegment(FileJob& job, const juce::String& error)
+{
+	const juce::ScopedLock lock(job.lock);
+
+	if (fail(job, error))
+		finishJob(job);
+}
+
+bool BatchRenderer::fail(FileJob& job, const juce::String& error)
+{
+	// First error is reported, waiting segments are dropped with the failed one
+	if (! job.failed)
+	{
+		job.failed = true;
+		job.result.error = error;
+	}
+
+	const int dropped = (int)job.pending.size();
+	job.pending.clear();
+
+	return settle(job, 1 + dropped);
+}
+
+bool BatchRenderer::settle(FileJob& job, int count)
+{
+	job.settled += count;
+	return job.settled == job.segments;
+}
+
+void BatchRenderer::finishJob(FileJob& job)
+{
+	// Closing the writer finishes the file header
+	job.writer.reset();
+
+	job.result.ok = ! job.failed;
+
+	// No partial output
+	if (job.failed)
+		job.outputFile.deleteFile();
+
+	printResult(job.inputFile, job.result, job.segments);
+}
+
+bool BatchRenderer::openWriter(FileJob& job, juce::String& error)
+{
+	auto* format = m_formatManager.findFormatForFileExtension(job.outputFile.getFileExtension());
+
+	job.outputFile.deleteFile();
+	std::unique_ptr<juce::OutputStream> stream(job.outputFile.createOutputStream());
+
+	if (format != nullptr && stream != nullptr)
+		job.writer.reset(format->createWriterFor(stream.get(), job.sampleRate, (unsigned int)job.channels, job.bitsPerSample, job.metadata, 0));
+
+	if (job.writer == nullptr)
+	{
+		error = "Cannot create " + job.outputFile.getFullPathName();
+		return false;
+	}
+
+	// Writer owns the stream now
+	stream.release();
+
+	return true;
+}
+
+void BatchRenderer::printResult(const juce::File& inputFile, const Result& result, int segments)
+{
+	const juce::ScopedLock lock(m_printLock);
+
+	if (! result.ok)
+		std::cerr << inputFile.getFileName() << ": " << result.error << std::endl;
+	else if (segments > 1)
+		std::cout << inputFile.getFileName() << ": " << result.audioSeconds << " s audio in " << segments << " segments, " << result.renderSeconds << " s total" << std::endl;
+	else
+		std::cout << inputFile.getFileName() << ": " << result.audioSeconds << " s audio in " << result.renderSeconds << " s" << std::endl;
+}
+
+void BatchRenderer::printProfile() const
+{
+	const auto& stats = m_profileStats;
+
+	if (stats.blocks == 0)
+		return;
+
+	// Usage is block time relative to the block period at the file's sample rate
+	std::cout << "processBlock: " << stats.blocks << " blocks, " << stats.getMeanNsPerSample() << " ns/sample, worst block " << stats.worstNs / 1000.0 << " us" << std::endl;
+	std::cout << "Budget usage: mean " << stats.getMeanUsage() * 100.0 << "%, p50 <= " << stats.getUsagePercentile(0.5) * 100.0
+	          << "%, p99 <= " << stats.getUsagePercentile(0.99) * 100.0 << "%, worst " << stats.worstUsage * 100.0 << "%" << std::endl;
+	std::cout << "Over budget (" << m_options.profileBudget * 100.0 << "%): " << stats.overBudget << " blocks" << std::endl;
+
+	for (int bin = 0; bin < BlockProfiler::HISTOGRAM_BINS; ++bin)
+	{
+		if (stats.histogram[bin] == 0)
+			continue;
+
+		const int lower = juce::roundToInt(bin * BlockProfiler::BIN_WIDTH * 100.0);
+
+		if (bin == BlockProfiler::HISTOGRAM_BINS - 1)
+			std::cout << "  >= " << lower << "%: " << stats.histogram[bin] << std::endl;
+		else
+			std::cout << "  " << lower << "-" << lower + juce::roundToInt(BlockProfiler::BIN_WIDTH * 100.0) << "%: " << stats.histogram[bin] << std::endl;
+	}
+}
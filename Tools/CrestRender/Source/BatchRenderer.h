@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    BatchRenderer.h
+
+    Renders audio files through CrestCompressorAudioProcessor on a pool of
+    worker threads. Every worker owns its processor instance, work is handed
+    out one file at a time, or one segment at a time for files longer than
+    two segments.
+
+    A segment starts its processor on a pre-roll of the audio before it, long
+    enough for the detector, envelope and silence state to converge to what a
+    single threaded render has at that point, and discards that output.
+    Segments are written in order as they complete.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Common/ProcessorSettings.h"
+
+#include <functional>
+#include <map>
+
+//==============================================================================
+class BatchRenderer
+{
+public:
+	struct Options
+	{
+		juce::File outputDirectory;
+		ProcessorSettings::Values parameters;
+		int numWorkers = 1;
+		int blockSize = 512;
+		bool profile = false;
+		double profileBudget = 0.5;	// Fraction of the block period
+
+		// Segment length in seconds, 0 renders every file on one worker
+		double segmentSeconds = 0.0;
+
+		// Covers the longest detector memory: 200 ms attack and release (10 time constants each for
+		// the idle tail), 500 ms window and 10 ms lookahead. Output then matches a single threaded
+		// render within < 0.001 dB.
+		double prerollSeconds = 5.0;
+	};
+
+	explicit BatchRenderer(const Options& options);
+
+	// Returns number of files that failed
+	int render(const juce::Array<juce::File>& inputFiles);
+
+private:
+	struct Result
+	{
+		bool ok = false;
+		juce::String error;
+		double audioSeconds = 0.0;
+		double renderSeconds = 0.0;
+	};
+
+	// One input file, its segments may be rendered by several workers
+	struct FileJob
+	{
+		juce::File inputFile;
+		juce::File outputFile;
+
+		double sampleRate = 0.0;
+		int channels = 0;
+		int bitsPerSample = 0;
+		juce::StringPairArray metadata;
+		juce::int64 length = 0;
+
+		int segments = 0;
+		juce::int64 segmentLength = 0;
+
+		// Guards everything below. The writer is used by one thread at a time, the one that set writing.
+		juce::CriticalSection lock;
+		std::unique_ptr<juce::AudioFormatWriter> writer;
+		std::map<int, juce::AudioBuffer<float>> pending;
+		int nextSegment = 0;
+		bool writing = false;
+		bool failed = false;
+
+		// Segments written, dropped after a failure or failed, the job is done at segments
+		int settled = 0;
+
+		Result result;
+	};
+
+	struct WorkItem
+	{
+		int job;
+		int segment;
+	};
+
+	// Rendered samples [start, start + samples) of block, in output sample positions
+	using BlockSink = std::function<bool(const juce::AudioBuffer<float>& block, int start, int samples, juce::int64 position)>;
+
+	std::unique_ptr<FileJob> createJob(const juce::File& inputFile);
+
+	void runWorker();
+	bool renderWholeFile(CrestCompressorAudioProcessor& processor, juce::AudioFormatReader& reader, FileJob& job, juce::String& error);
+	void renderSegment(CrestCompressorAudioProcessor& processor, juce::AudioFormatReader& reader, FileJob& job, int segment);
+
+	// Output [first, first + count) of the file, preceded by a discarded pre-roll of prerollSamples. False when the sink failed.
+	bool renderRange(CrestCompressorAudioProcessor& processor, juce::AudioFormatReader& reader, FileJob& job,
+	                 juce::int64 first, juce::int64 count, juce::int64 prerollSamples, const BlockSink& sink);
+
+	// Any thread. Queues a rendered segment, writes every segment that is next in order.
+	void submitSegment(FileJob& job, int segment, juce::AudioBuffer<float>&& buffer);
+	void failSegment(FileJob& job, const juce::String& error);
+
+	// Called with job.lock held, true when this completed the job
+	bool fail(FileJob& job, const juce::String& error);
+	bool settle(FileJob& job, int count);
+	void finishJob(FileJob& job);
+
+	bool openWriter(FileJob& job, juce::String& error);
+
+	void printResult(const juce::File& inputFile, const Result& result, int segments);
+	void printProfile() const;
+
+	Options m_options;
+	juce::AudioFormatManager m_formatManager;
+
+	std::vector<std::unique_ptr<FileJob>> m_jobs;
+	std::vector<WorkItem> m_work;
+	std::atomic<int> m_nextWork{ 0 };
+	BlockProfiler::Stats m_profileStats;
+
+	juce::CriticalSection m_printLock;
+
+	JUCE_DECLARE_NON_COPYABLE(BatchRenderer)
+};
@@ -0,0 +1,386 @@
+/*
+  ==============================================================================
+
+    CrestAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "CrestAnalyzer.h"
+
+#include <iostream>
+#include <thread>
+
+//==============================================================================
+namespace
+{
+	// Samples read at once, detector runs over them in MAX_BLOCK pieces
+	const int READ_BLOCK = 8192;
+	const int DETECTOR_BLOCK = DetectorBank<float>::MAX_BLOCK;
+}
+
+//==============================================================================
+void CrestAnalyzer::Histogram::merge(const Histogram& other)
+{
+	for (int bin = 0; bin < HISTOGRAM_BINS; ++bin)
+		counts[(size_t)bin] += other.counts[(size_t)bin];
+
+	total += other.total;
+	maximum = std::max(maximum, other.maximum);
+}
+
+float CrestAnalyzer::Histogram::getPercentile(double fraction) const
+{
+	const double target = fraction * (double)total;
+	juce::uint64 count = 0;
+
+	if (total == 0)
+		return 0.0f;
+
+	for (int bin = 0; bin < HISTOGRAM_BINS; ++bin)
+	{
+		count += counts[(size_t)bin];
+
+		if ((double)count >= target)
+			return std::min((bin + 1) * BIN_WIDTH, maximum);
+	}
+
+	return maximum;
+}
+
+CrestAnalyzer::Suggestion CrestAnalyzer::suggest(const Histogram& histogram, double coverage, float reductionDb)
+{
+	Suggestion suggestion;
+	const float crestLimit = CrestCompressorAudioProcessor::CREST_LIMIT;
+
+	// Nothing but silence, the processor idles anyway
+	if (histogram.total == 0)
+	{
+		suggestion.threshold = crestLimit * 0.5f;
+		return suggestion;
+	}
+
+	// Threshold has steps of 1, only the loudest transients are above it
+	suggestion.threshold = juce::jlimit(0.0f, crestLimit, (float)std::round(histogram.getPercentile(1.0 - coverage)));
+
+	// Attenuation is (crest - threshold) / CREST_LIMIT * |ratio| * 4 dB, see getTargetParameters
+	const float excess = std::max(histogram.getPercentile(0.99) - suggestion.threshold, BIN_WIDTH) / crestLimit;
+	suggestion.ratio = -juce::jlimit(1.0f, 24.0f, (float)std::round(reductionDb / (excess * 4.0f)));
+
+	return suggestion;
+}
+
+//==============================================================================
+CrestAnalyzer::CrestAnalyzer(const Options& options)
+	: m_options(options)
+{
+	// WAV, AIFF, FLAC, Ogg
+	m_formatManager.registerBasicFormats();
+}
+
+int CrestAnalyzer::analyze(const juce::Array<juce::File>& inputFiles)
+{
+	m_jobs.clear();
+	m_work.clear();
+	m_nextWork = 0;
+	m_total = {};
+
+	for (const auto& inputFile : inputFiles)
+	{
+		m_jobs.push_back(createJob(inputFile));
+		auto& job = *m_jobs.back();
+
+		if (job.error.isNotEmpty())
+		{
+			const juce::ScopedLock lock(m_printLock);
+			std::cerr << inputFile.getFileName() << ": " << job.error << std::endl;
+			continue;
+		}
+
+		for (int chunk = 0; chunk < job.chunks; ++chunk)
+			m_work.push_back({ (int)m_jobs.size() - 1, chunk });
+	}
+
+	const int numWorkers = juce::jlimit(1, juce::jmax(1, (int)m_work.size()), m_options.numWorkers);
+
+	const auto startTicks = juce::Time::getHighResolutionTicks();
+
+	std::vector<std::thread> workers;
+	for (int i = 0; i < numWorkers; ++i)
+		workers.emplace_back([this] { runWorker(); });
+
+	for (auto& worker : workers)
+		worker.join();
+
+	const double wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+	// Summary
+	int failed = 0;
+	double audioSeconds = 0.0;
+
+	for (const auto& job : m_jobs)
+	{
+		if (job->ok)
+			audioSeconds += (double)job->length / job->sampleRate;
+		else
+			failed++;
+	}
+
+	const int analyzed = inputFiles.size() - failed;
+
+	// Whole set, e.g. an album that should share one setting
+	if (analyzed > 1)
+	{
+		printResult("All files", m_total, audioSeconds);
+
+		if (! writeResults(m_options.outputDirectory.getChildFile("all.crest.csv"), m_options.outputDirectory.getChildFile("all.preset.txt"), "all files", m_total))
+			std::cerr << "Cannot write results of all files to " << m_options.outputDirectory.getFullPathName() << std::endl;
+	}
+
+	std::cout << "Analyzed " << analyzed << " of " << inputFiles.size() << " files in " << m_work.size() << " chunks with " << numWorkers << " workers in " << wallSeconds << " s" << std::endl;
+
+	if (wallSeconds > 0.0)
+		std::cout << "Realtime factor: " << audioSeconds / wallSeconds << "x" << std::endl;
+
+	return failed;
+}
+
+std::unique_ptr<CrestAnalyzer::FileJob> CrestAnalyzer::createJob(const juce::File& inputFile)
+{
+	auto job = std::make_unique<FileJob>();
+	job->inputFile = inputFile;
+	job->format = m_formatManager.findFormatForFileExtension(inputFile.getFileExtension());
+
+	std::unique_ptr<juce::AudioFormatReader> reader;
+
+	// WAV and AIFF map the file, other formats decode through a stream
+	if (job->format != nullptr)
+	{
+		reader.reset(job->format->createMemoryMappedReader(inputFile));
+		job->memoryMapped = reader != nullptr;
+	}
+
+	if (reader == nullptr)
+		reader.reset(m_formatManager.createReaderFor(inputFile));
+
+	if (reader == nullptr)
+	{
+		job->error = "Unsupported or unreadable file";
+		return job;
+	}
+
+	job->sampleRate = reader->sampleRate;
+	job->channels = (int)reader->numChannels;
+	job->length = reader->lengthInSamples;
+
+	if (job->channels < 1)
+	{
+		job->error = "File has no channels";
+		return job;
+	}
+
+	const juce::int64 chunkLength = (juce::int64)(m_options.chunkSeconds * job->sampleRate);
+
+	// Shorter files are not worth the pre-roll
+	if (chunkLength > 0 && job->length > 2 * chunkLength)
+	{
+		job->chunkLength = chunkLength;
+		job->chunks = (int)((job->length + chunkLength - 1) / chunkLength);
+	}
+	else
+	{
+		job->chunkLength = job->length;
+		job->chunks = 1;
+	}
+
+	return job;
+}
+
+void CrestAnalyzer::runWorker()
+{
+	// Reader is kept while consecutive chunks come from the same file
+	std::unique_ptr<juce::AudioFormatReader> reader;
+	juce::MemoryMappedAudioFormatReader* mappedReader = nullptr;
+	int readerJob = -1;
+
+	for (int index = m_nextWork++; index < (int)m_work.size(); index = m_nextWork++)
+	{
+		const auto item = m_work[(size_t)index];
+		auto& job = *m_jobs[(size_t)item.job];
+
+		const auto startTicks = juce::Time::getHighResolutionTicks();
+
+		if (readerJob != item.job)
+		{
+			mappedReader = job.memoryMapped ? job.format->createMemoryMappedReader(job.inputFile) : nullptr;
+			reader.reset(mappedReader != nullptr ? mappedReader : m_formatManager.createReaderFor(job.inputFile));
+			readerJob = item.job;
+		}
+
+		const juce::int64 first = item.chunk * job.chunkLength;
+		const juce::int64 count = juce::jmin(job.chunkLength, job.length - first);
+		const juce::int64 start = juce::jmax((juce::int64)0, first - (juce::int64)(m_options.prerollSeconds * job.sampleRate));
+
+		Histogram histogram;
+		bool ok = reader != nullptr;
+
+		// Only the pages of this chunk are mapped
+		if (ok && mappedReader != nullptr && count > 0)
+			ok = mappedReader->mapSectionOfFile({ start, first + count });
+
+		if (ok)
+			ok = analyzeRange(*reader, job, first, count, first - start, histogram);
+
+		const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+		const juce::ScopedLock lock(job.lock);
+
+		job.histogram.merge(histogram);
+		job.analyzeSeconds += seconds;
+
+		if (! ok && ! job.failed)
+		{
+			job.failed = true;
+			job.error = (reader == nullptr) ? "Unsupported or unreadable file" : "Cannot map or read file";
+		}
+
+		if (++job.settled == job.chunks)
+			finishJob(job);
+	}
+}
+
+bool CrestAnalyzer::analyzeRange(juce::AudioFormatReader& reader, const FileJob& job, juce::int64 first, juce::int64 count,
+                                 juce::int64 prerollSamples, Histogram& histogram)
+{
+	const int channels = job.channels;
+	const float crestLimit = CrestCompressorAudioProcessor::CREST_LIMIT;
+	const float silenceLevel = CrestCompressorAudioProcessor::SILENCE_LEVEL;
+
+	// The processor's exponential detector, 100 ms peak and RMS
+	DetectorBank<float> detector;
+	detector.prepare(channels, (int)job.sampleRate);
+	detector.setKernels(DspKernels::getTable<float>(DspKernels::getBestInstructionSet()));
+	detector.setCrestCoef(0.1f);
+
+	juce::AudioBuffer<float> buffer(channels, READ_BLOCK);
+	juce::AudioBuffer<float> crestSQ(channels, DETECTOR_BLOCK);
+
+	const juce::int64 start = first - prerollSamples;
+	const juce::int64 end = first + count;
+
+	for (juce::int64 position = start; position < end; position += READ_BLOCK)
+	{
+		const int samples = (int)juce::jmin((juce::int64)READ_BLOCK, end - position);
+
+		reader.read(&buffer, 0, samples, position, true, true);
+
+		for (int offset = 0; offset < samples; offset += DETECTOR_BLOCK)
+		{
+			const int detectorSamples = std::min(DETECTOR_BLOCK, samples - offset);
+			detector.processCrestSQ(buffer.getArrayOfReadPointers(), offset, crestSQ.getArrayOfWritePointers(), detectorSamples);
+
+			// Pre-roll output is discarded
+			const int skip = (int)juce::jlimit((juce::int64)0, (juce::int64)detectorSamples, first - (position + offset));
+			const int keep = detectorSamples - skip;
+
+			if (keep == 0)
+				continue;
+
+			// The processor idles on silence, it would only count as crest factor 1
+			float peak = 0.0f;
+
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				const auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel, offset + skip), keep);
+				peak = std::max(peak, std::max(-range.getStart(), range.getEnd()));
+			}
+
+			if (peak <= silenceLevel)
+				continue;
+
+			// Skewed crest factor, as compared with the threshold, see DspKernels::attenuation
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				const float* in = crestSQ.getReadPointer(channel, skip);
+
+				for (int sample = 0; sample < keep; ++sample)
+				{
+					const float crestFactor = std::sqrt(std::min(std::sqrt(in[sample]) / crestLimit, 1.0f)) * crestLimit;
+					histogram.counts[(size_t)std::min((int)(crestFactor / BIN_WIDTH), HISTOGRAM_BINS - 1)]++;
+					histogram.maximum = std::max(histogram.maximum, crestFactor);
+				}
+			}
+
+			histogram.total += (juce::uint64)(keep * channels);
+		}
+	}
+
+	return true;
+}
+
+void CrestAnalyzer::finishJob(FileJob& job)
+{
+	const auto name = job.inputFile.getFileName();
+
+	if (job.failed)
+	{
+		const juce::ScopedLock lock(m_printLock);
+		std::cerr << name << ": " << job.error << std::endl;
+		return;
+	}
+
+	const auto histogramFile = m_options.outputDirectory.getChildFile(name + ".crest.csv");
+	const auto presetFile = m_options.outputDirectory.getChildFile(name + ".preset.txt");
+
+	if (! writeResults(histogramFile, presetFile, name, job.histogram))
+	{
+		const juce::ScopedLock lock(m_printLock);
+		std::cerr << name << ": Cannot write " << histogramFile.getFullPathName() << std::endl;
+		return;
+	}
+
+	job.ok = true;
+	printResult(name + " (" + juce::String(job.analyzeSeconds, 2) + " s)", job.histogram, (double)job.length / job.sampleRate);
+
+	const juce::ScopedLock lock(m_printLock);
+	m_total.merge(job.histogram);
+}
+
+bool CrestAnalyzer::writeResults(const juce::File& histogramFile, const juce::File& presetFile, const juce::String& name, const Histogram& histogram) const
+{
+	// Fraction of the non silent samples per bin and up to the bin's upper edge
+	juce::String csv = "crest_low,crest_high,fraction,cumulative\n";
+	juce::uint64 count = 0;
+
+	for (int bin = 0; bin < HISTOGRAM_BINS; ++bin)
+	{
+		count += histogram.counts[(size_t)bin];
+
+		const double total = (double)juce::jmax((juce::uint64)1, histogram.total);
+		csv << juce::String(bin * BIN_WIDTH, 1) << ',' << juce::String((bin + 1) * BIN_WIDTH, 1) << ','
+		    << juce::String((double)histogram.counts[(size_t)bin] / total, 6) << ',' << juce::String((double)count / total, 6) << '\n';
+	}
+
+	const auto suggestion = suggest(histogram, m_options.coverage, m_options.reductionDb);
+
+	juce::String preset;
+	preset << "# Crest factor of " << name << " in threshold units, exponential detector\n"
+	       << "# p50 <= " << histogram.getPercentile(0.5) << ", p90 <= " << histogram.getPercentile(0.9)
+	       << ", p99 <= " << histogram.getPercentile(0.99) << ", max " << histogram.maximum << '\n'
+	       << "# " << m_options.coverage * 100.0 << " % above Threshold, " << m_options.reductionDb << " dB reduction at p99\n"
+	       << "Detector=Exponential\n"
+	       << "Threshold=" << suggestion.threshold << '\n'
+	       << "Attack=" << suggestion.ratio << '\n';
+
+	return histogramFile.replaceWithText(csv) && presetFile.replaceWithText(preset);
+}
+
+void CrestAnalyzer::printResult(const juce::String& name, const Histogram& histogram, double seconds)
+{
+	const juce::ScopedLock lock(m_printLock);
+	const auto suggestion = suggest(histogram, m_options.coverage, m_options.reductionDb);
+
+	std::cout << name << ": " << seconds << " s audio, crest p10 " << histogram.getPercentile(0.1) << ", p50 " << histogram.getPercentile(0.5)
+	          << ", p90 " << histogram.getPercentile(0.9) << ", p99 " << histogram.getPercentile(0.99) << ", max " << histogram.maximum
+	          << " -> Threshold=" << suggestion.threshold << " Attack=" << suggestion.ratio << std::endl;
+}
@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    CrestAnalyzer.h
+
+    Crest factor statistics of audio files, without the gain stage. Runs the
+    processor's exponential crest detector (DetectorBank, best kernels) over
+    every channel and counts its output in threshold units, the scale of the
+    Threshold parameter and the editor's Crest meter.
+
+    Files are split into chunks that run in parallel like the segments of
+    BatchRenderer, each chunk's detector warms up on a pre-roll of the audio
+    before it. Histograms are sums, chunks merge in any order. WAV and AIFF
+    are read through a memory map of the chunk.
+
+    Writes per file and for all files a histogram CSV and a preset with the
+    suggested Threshold and ratio, loadable with --preset.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+#include <array>
+
+//==============================================================================
+class CrestAnalyzer
+{
+public:
+	// Threshold units, 0 .. CREST_LIMIT in bins of the Threshold parameter's half step
+	static const int HISTOGRAM_BINS = 100;
+	static constexpr float BIN_WIDTH = DspKernels::CREST_LIMIT / HISTOGRAM_BINS;
+
+	struct Options
+	{
+		juce::File outputDirectory;
+		int numWorkers = 1;
+		double chunkSeconds = 30.0;
+
+		// Ten time constants of the 100 ms crest detector
+		double prerollSeconds = 1.0;
+
+		// Share of the non silent time the suggested threshold leaves above it
+		double coverage = 0.1;
+
+		// Gain reduction the suggested ratio gives at the 99th percentile
+		float reductionDb = 6.0f;
+	};
+
+	struct Histogram
+	{
+		std::array<juce::uint64, HISTOGRAM_BINS> counts{};
+		juce::uint64 total = 0;
+		float maximum = 0.0f;
+
+		void merge(const Histogram& other);
+
+		// Upper edge of the bin holding the fraction, 0 when empty
+		float getPercentile(double fraction) const;
+	};
+
+	struct Suggestion
+	{
+		float threshold = 0.0f;
+		float ratio = 0.0f;    // Attack parameter, negative compresses
+	};
+
+	static Suggestion suggest(const Histogram& histogram, double coverage, float reductionDb);
+
+	explicit CrestAnalyzer(const Options& options);
+
+	// Returns number of files that failed
+	int analyze(const juce::Array<juce::File>& inputFiles);
+
+private:
+	struct FileJob
+	{
+		juce::File inputFile;
+		juce::AudioFormat* format = nullptr;
+		bool memoryMapped = false;
+
+		double sampleRate = 0.0;
+		int channels = 0;
+		juce::int64 length = 0;
+
+		int chunks = 0;
+		juce::int64 chunkLength = 0;
+
+		// Guards everything below
+		juce::CriticalSection lock;
+		Histogram histogram;
+		double analyzeSeconds = 0.0;
+		int settled = 0;
+		bool failed = false;
+		bool ok = false;
+		juce::String error;
+	};
+
+	struct WorkItem
+	{
+		int job;
+		int chunk;
+	};
+
+	std::unique_ptr<FileJob> createJob(const juce::File& inputFile);
+
+	void runWorker();
+
+	// Detector output of [first, first + count) into histogram, after prerollSamples of warm up
+	bool analyzeRange(juce::AudioFormatReader& reader, const FileJob& job, juce::int64 first, juce::int64 count,
+	                  juce::int64 prerollSamples, Histogram& histogram);
+
+	void finishJob(FileJob& job);
+
+	bool writeResults(const juce::File& histogramFile, const juce::File& presetFile, const juce::String& name, const Histogram& histogram) const;
+	void printResult(const juce::String& name, const Histogram& histogram, double seconds);
+
+	Options m_options;
+	juce::AudioFormatManager m_formatManager;
+
+	std::vector<std::unique_ptr<FileJob>> m_jobs;
+	std::vector<WorkItem> m_work;
+	std::atomic<int> m_nextWork{ 0 };
+
+	// All files, merged as files finish
+	Histogram m_total;
+
+	juce::CriticalSection m_printLock;
+
+	JUCE_DECLARE_NON_COPYABLE(CrestAnalyzer)
+};
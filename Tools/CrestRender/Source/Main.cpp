@@ -0,0 +1,334 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Headless batch renderer for CrestCompressorAudioProcessor.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "BatchRenderer.h"
+#include "CrestAnalyzer.h"
+#include "StreamRenderer.h"
+
+#include <iostream>
+
+//==============================================================================
+static void printUsage()
+{
+	std::cout << "Usage: CrestRender [options] <input files>" << std::endl
+	          << "       CrestRender --stream [options] < input.raw > output.raw" << std::endl
+	          << "       CrestRender --analyze -o <dir> [options] <input files>" << std::endl
+	          << "  -o, --output <dir>      Output directory (required)" << std::endl
+	          << "  -p, --param <Name=val>  Set parameter, can be repeated" << std::endl
+	          << "      --preset <file>     Load Name=value lines, --param overrides" << std::endl
+	          << "  -j, --jobs <n>          Worker threads (default: number of CPUs)" << std::endl
+	          << "  -b, --block <n>         Block size in samples (default: 512)" << std::endl
+	          << "      --segment <s>       Split files longer than two segments across workers (default: off, try 60; analysis: 30)" << std::endl
+	          << "      --preroll <s>       Audio each segment's detector warms up on (default: 5; analysis: 1)" << std::endl
+	          << "      --stream            Interleaved raw PCM from stdin to stdout, same length and format" << std::endl
+	          << "      --format <f>        Stream sample format: f32, s16, s24 (default: f32)" << std::endl
+	          << "      --rate <hz>         Stream sample rate (default: 48000)" << std::endl
+	          << "      --channels <n>      Stream channels (default: 2)" << std::endl
+	          << "      --analyze           Crest factor histograms and suggested Threshold / ratio presets, no rendering" << std::endl
+	          << "      --coverage <percent> Analysis: non silent time above the suggested threshold (default: 10)" << std::endl
+	          << "      --reduction <dB>    Analysis: gain reduction at the 99th percentile crest factor (default: 6)" << std::endl
+	          << "      --profile           Print processBlock timing and budget usage" << std::endl
+	          << "      --budget <percent>  Block period share counted as over budget (default: 50)" << std::endl
+	          << "      --check             Render test files and exit non-zero unless output matches input" << std::endl
+	          << "Parameters: Smooth, Lenght, Attack, Threshold, Mix, Volume, Lookahead, Window, Kernel, Bands, Detector, Rate, Link," << std::endl
+	          << "            Oversampling, Crossover1-3, Threshold2-4, Ratio2-4" << std::endl;
+}
+
+//==============================================================================
+// --check: at ratio 0 the processor only delays, so a render with latency compensated must return its
+// input. Lookahead is longer than a block and segments start mid file, which catches a render that reads
+// input late or misplaces a segment's pre-roll.
+static bool checkRender(const juce::File& directory, double sampleRate, int blockSize, double segmentSeconds)
+{
+	const int channels = 2;
+	const int length = (int)(2.0 * sampleRate);
+	const auto inputFile = directory.getChildFile("input").getChildFile("noise.wav");
+	const auto outputDirectory = directory.getChildFile("output");
+
+	juce::AudioBuffer<float> input(channels, length);
+	juce::Random random(1);
+
+	for (int channel = 0; channel < channels; ++channel)
+		for (int sample = 0; sample < length; ++sample)
+			input.setSample(channel, sample, 0.5f * (2.0f * random.nextFloat() - 1.0f));
+
+	juce::AudioFormatManager formatManager;
+	formatManager.registerBasicFormats();
+
+	// 32 bit float, written and read back exactly
+	{
+		inputFile.getParentDirectory().createDirectory();
+		inputFile.deleteFile();
+		std::unique_ptr<juce::OutputStream> stream(inputFile.createOutputStream());
+		std::unique_ptr<juce::AudioFormatWriter> writer;
+
+		if (stream != nullptr)
+			writer.reset(juce::WavAudioFormat().createWriterFor(stream.get(), sampleRate, (unsigned int)channels, 32, {}, 0));
+
+		if (writer == nullptr)
+			return false;
+
+		stream.release();
+
+		if (! writer->writeFromAudioSampleBuffer(input, 0, length))
+			return false;
+	}
+
+	BatchRenderer::Options options;
+	options.outputDirectory = outputDirectory;
+	options.numWorkers = 2;
+	options.blockSize = blockSize;
+	options.segmentSeconds = segmentSeconds;
+	options.prerollSeconds = 0.1;
+	options.parameters.set("Attack", "0");
+	options.parameters.set("Lookahead", juce::String(CrestCompressorAudioProcessor::LOOKAHEAD_LIMIT_MS));
+
+	outputDirectory.createDirectory();
+
+	BatchRenderer renderer(options);
+
+	if (renderer.render({ inputFile }) != 0)
+		return false;
+
+	std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(outputDirectory.getChildFile(inputFile.getFileName())));
+
+	if (reader == nullptr || reader->lengthInSamples != length || (int)reader->numChannels != channels)
+		return false;
+
+	juce::AudioBuffer<float> output(channels, length);
+	reader->read(&output, 0, length, 0, true, true);
+
+	float maxError = 0.0f;
+
+	for (int channel = 0; channel < channels; ++channel)
+		for (int sample = 0; sample < length; ++sample)
+			maxError = juce::jmax(maxError, std::abs(output.getSample(channel, sample) - input.getSample(channel, sample)));
+
+	return maxError <= 1.0e-6f;
+}
+
+static int runChecks()
+{
+	const auto directory = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("CrestRenderCheck", "");
+	int failures = 0;
+
+	// Latency 960 at 96 kHz, longer than both blocks. Segments of 0.25 s split the 2 s file into 8.
+	for (int blockSize : { 64, 512 })
+	{
+		for (double segmentSeconds : { 0.0, 0.25 })
+		{
+			const bool ok = checkRender(directory, 96000.0, blockSize, segmentSeconds);
+			std::cout << (ok ? "PASS " : "FAIL ") << "ratio 0 render equals input, block " << blockSize << ", segment " << segmentSeconds << " s" << std::endl;
+
+			if (! ok)
+				++failures;
+		}
+	}
+
+	directory.deleteRecursively();
+
+	std::cout << (failures == 0 ? "All checks passed" : juce::String(failures) + " checks failed") << std::endl;
+	return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	// Message manager for the processor's parameter tree
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	BatchRenderer::Options options;
+	options.numWorkers = juce::SystemStats::getNumCpus();
+
+	StreamRenderer::Options streamOptions;
+	bool stream = false;
+
+	CrestAnalyzer::Options analyzerOptions;
+	bool analyze = false;
+	double preroll = -1.0;
+	double segment = -1.0;
+
+	ProcessorSettings::Values presetValues;
+	ProcessorSettings::Values commandLineValues;
+	juce::Array<juce::File> inputFiles;
+	juce::String error;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const juce::String arg(argv[i]);
+		const bool hasValue = i + 1 < argc;
+
+		if ((arg == "-o" || arg == "--output") && hasValue)
+		{
+			options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+		}
+		else if ((arg == "-p" || arg == "--param") && hasValue)
+		{
+			if (! ProcessorSettings::parseAssignment(argv[++i], commandLineValues, error))
+				break;
+		}
+		else if (arg == "--preset" && hasValue)
+		{
+			if (! ProcessorSettings::loadPresetFile(juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]), presetValues, error))
+				break;
+		}
+		else if ((arg == "-j" || arg == "--jobs") && hasValue)
+		{
+			options.numWorkers = juce::jmax(1, juce::String(argv[++i]).getIntValue());
+		}
+		else if ((arg == "-b" || arg == "--block") && hasValue)
+		{
+			options.blockSize = juce::jlimit(1, 65536, juce::String(argv[++i]).getIntValue());
+		}
+		else if (arg == "--segment" && hasValue)
+		{
+			segment = juce::jmax(0.0, juce::String(argv[++i]).getDoubleValue());
+		}
+		else if (arg == "--preroll" && hasValue)
+		{
+			preroll = juce::jmax(0.0, juce::String(argv[++i]).getDoubleValue());
+		}
+		else if (arg == "--stream")
+		{
+			stream = true;
+		}
+		else if (arg == "--format" && hasValue)
+		{
+			if (! StreamRenderer::parseFormat(argv[++i], streamOptions.format))
+			{
+				error = "Unknown sample format " + juce::String(argv[i]);
+				break;
+			}
+		}
+		else if (arg == "--rate" && hasValue)
+		{
+			streamOptions.sampleRate = juce::jlimit(8000.0, 768000.0, juce::String(argv[++i]).getDoubleValue());
+		}
+		else if (arg == "--channels" && hasValue)
+		{
+			streamOptions.channels = juce::jlimit(1, 64, juce::String(argv[++i]).getIntValue());
+		}
+		else if (arg == "--analyze")
+		{
+			analyze = true;
+		}
+		else if (arg == "--coverage" && hasValue)
+		{
+			analyzerOptions.coverage = juce::jlimit(0.1, 100.0, juce::String(argv[++i]).getDoubleValue()) * 0.01;
+		}
+		else if (arg == "--reduction" && hasValue)
+		{
+			analyzerOptions.reductionDb = juce::jlimit(0.1f, 18.0f, juce::String(argv[++i]).getFloatValue());
+		}
+		else if (arg == "--profile")
+		{
+			options.profile = true;
+		}
+		else if (arg == "--budget" && hasValue)
+		{
+			options.profileBudget = juce::jlimit(1.0, 1000.0, juce::String(argv[++i]).getDoubleValue()) * 0.01;
+		}
+		else if (arg == "--check")
+		{
+			return runChecks();
+		}
+		else if (arg == "-h" || arg == "--help")
+		{
+			printUsage();
+			return 0;
+		}
+		else if (arg.startsWith("-"))
+		{
+			error = "Unknown option " + arg;
+			break;
+		}
+		else
+		{
+			inputFiles.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+		}
+	}
+
+	if (error.isEmpty() && stream && analyze)
+		error = "--stream and --analyze exclude each other";
+
+	if (error.isEmpty() && stream && ! inputFiles.isEmpty())
+		error = "No input files in stream mode";
+
+	if (error.isEmpty() && ! stream && options.outputDirectory == juce::File())
+		error = "Missing output directory";
+
+	if (error.isEmpty() && ! stream && inputFiles.isEmpty())
+		error = "No input files";
+
+	// Command line overrides the preset
+	options.parameters = presetValues;
+	options.parameters.addArray(commandLineValues);
+
+	if (error.isEmpty())
+	{
+		// Validate parameters once before starting workers
+		CrestCompressorAudioProcessor processor;
+		ProcessorSettings::apply(processor, options.parameters, error);
+	}
+
+	if (error.isEmpty() && ! stream && ! options.outputDirectory.createDirectory())
+		error = "Cannot create output directory " + options.outputDirectory.getFullPathName();
+
+	if (error.isNotEmpty())
+	{
+		std::cerr << error << std::endl;
+
+		// Stdout of a stream is someone's audio input
+		if (! stream)
+			printUsage();
+
+		return 1;
+	}
+
+	// Stdout carries the audio, messages go to stderr
+	if (stream)
+	{
+		streamOptions.parameters = options.parameters;
+		streamOptions.blockSize = options.blockSize;
+
+		StreamRenderer renderer(streamOptions);
+
+		if (renderer.run(error))
+			return 0;
+
+		std::cerr << error << std::endl;
+		return 1;
+	}
+
+	// Segment and pre-roll defaults differ, the analysis detector has a shorter memory
+	if (analyze)
+	{
+		analyzerOptions.outputDirectory = options.outputDirectory;
+		analyzerOptions.numWorkers = options.numWorkers;
+
+		if (segment >= 0.0)
+			analyzerOptions.chunkSeconds = segment;
+
+		if (preroll >= 0.0)
+			analyzerOptions.prerollSeconds = preroll;
+
+		CrestAnalyzer analyzer(analyzerOptions);
+		return analyzer.analyze(inputFiles) == 0 ? 0 : 1;
+	}
+
+	if (segment >= 0.0)
+		options.segmentSeconds = segment;
+
+	if (preroll >= 0.0)
+		options.prerollSeconds = preroll;
+
+	BatchRenderer renderer(options);
+	return renderer.render(inputFiles) == 0 ? 0 : 1;
+}
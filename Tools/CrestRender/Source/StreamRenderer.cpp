@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+
+    StreamRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "StreamRenderer.h"
+
+#include <cstdio>
+#include <thread>
+
+#if JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <io.h>
+#endif
+
+//==============================================================================
+namespace
+{
+	using Float = juce::AudioData::Pointer<juce::AudioData::Float32, juce::AudioData::NativeEndian, juce::AudioData::NonInterleaved, juce::AudioData::NonConst>;
+	using ConstFloat = juce::AudioData::Pointer<juce::AudioData::Float32, juce::AudioData::NativeEndian, juce::AudioData::NonInterleaved, juce::AudioData::Const>;
+
+	// Interleaved bytes -> channels of buffer, frames samples each
+	template <typename Format, typename Endianness>
+	void deinterleave(const char* source, juce::AudioBuffer<float>& buffer, int frames)
+	{
+		using Source = juce::AudioData::Pointer<Format, Endianness, juce::AudioData::Interleaved, juce::AudioData::Const>;
+		const int channels = buffer.getNumChannels();
+
+		for (int channel = 0; channel < channels; ++channel)
+			Float(buffer.getWritePointer(channel)).convertSamples(Source(source + channel * Format::bytesPerSample, channels), frames);
+	}
+
+	// Integer formats clip, float passes unchanged
+	template <typename Format, typename Endianness>
+	void interleave(const juce::AudioBuffer<float>& buffer, int start, int frames, char* dest)
+	{
+		using Dest = juce::AudioData::Pointer<Format, Endianness, juce::AudioData::Interleaved, juce::AudioData::NonConst>;
+		const int channels = buffer.getNumChannels();
+
+		for (int channel = 0; channel < channels; ++channel)
+			Dest(dest + channel * Format::bytesPerSample, channels).convertSamples(ConstFloat(buffer.getReadPointer(channel, start)), frames);
+	}
+}
+
+//==============================================================================
+void StreamRenderer::SlotQueue::push(int slot)
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_closed)
+		return;
+
+	// Never more entries than slots exist
+	jassert(m_count < SLOTS);
+
+	m_slots[(m_read + m_count) % SLOTS] = slot;
+	m_count++;
+
+	m_condition.notify_one();
+}
+
+bool StreamRenderer::SlotQueue::pop(int& slot)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condition.wait(lock, [this] { return m_count > 0 || m_closed; });
+
+	if (m_closed)
+		return false;
+
+	slot = m_slots[m_read];
+	m_read = (m_read + 1) % SLOTS;
+	m_count--;
+
+	return true;
+}
+
+void StreamRenderer::SlotQueue::close()
+{
+	const std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_closed = true;
+	m_condition.notify_all();
+}
+
+//==============================================================================
+StreamRenderer::StreamRenderer(const Options& options)
+	: m_options(options)
+{
+	using namespace juce::AudioData;
+
+	switch (m_options.format)
+	{
+		case SampleFormat::Int16:
+			m_deinterleave = deinterleave<Int16, LittleEndian>;
+			m_interleave = interleave<Int16, LittleEndian>;
+			m_frameBytes = m_options.channels * Int16::bytesPerSample;
+			break;
+
+		case SampleFormat::Int24:
+			m_deinterleave = deinterleave<Int24, LittleEndian>;
+			m_interleave = interleave<Int24, LittleEndian>;
+			m_frameBytes = m_options.channels * Int24::bytesPerSample;
+			break;
+
+		case SampleFormat::Float32:
+		default:
+			m_deinterleave = deinterleave<Float32, NativeEndian>;
+			m_interleave = interleave<Float32, NativeEndian>;
+			m_frameBytes = m_options.channels * Float32::bytesPerSample;
+			break;
+	}
+
+	for (int slot = 0; slot < SLOTS; ++slot)
+	{
+		m_input[slot].bytes.allocate((size_t)(m_options.blockSize * m_frameBytes), false);
+		m_output[slot].bytes.allocate((size_t)(m_options.blockSize * m_frameBytes), false);
+	}
+}
+
+bool StreamRenderer::parseFormat(const juce::String& text, SampleFormat& format)
+{
+	if (text == "f32")
+		format = SampleFormat::Float32;
+	else if (text == "s16")
+		format = SampleFormat::Int16;
+	else if (text == "s24")
+		format = SampleFormat::Int24;
+	else
+		return false;
+
+	return true;
+}
+
+bool StreamRenderer::run(juce::String& error)
+{
+	const int channels = m_options.channels;
+	const int blockSize = m_options.blockSize;
+
+	auto processor = std::make_unique<CrestCompressorAudioProcessor>();
+
+	if (! ProcessorSettings::apply(*processor, m_options.parameters, error))
+		return false;
+
+	processor->setNonRealtime(true);
+	processor->setPlayConfigDetails(channels, channels, m_options.sampleRate, blockSize);
+	processor->prepareToPlay(m_options.sampleRate, blockSize);
+
+	juce::AudioBuffer<float> buffer(channels, blockSize);
+	juce::MidiBuffer midiMessages;
+
+	// Raw bytes, whole blocks go straight between the pipes and the slots
+   #if JUCE_WINDOWS
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+   #endif
+	std::setvbuf(stdin, nullptr, _IONBF, 0);
+	std::setvbuf(stdout, nullptr, _IONBF, 0);
+
+	for (int slot = 0; slot < SLOTS; ++slot)
+	{
+		m_inputFree.push(slot);
+		m_outputFree.push(slot);
+	}
+
+	std::thread reader([this] { runReader(); });
+	std::thread writer([this] { runWriter(); });
+
+	// Lookahead delays the output, its first latency samples are dropped and the tail is flushed with silence
+	const int latency = processor->getLatencySamples();
+	int skip = latency;
+	int flush = latency;
+
+	// Processed buffer to the writer, false once the writer gave up
+	const auto send = [this, &buffer, &skip](int frames)
+	{
+		const int dropped = juce::jmin(skip, frames);
+		skip -= dropped;
+
+		if (dropped == frames)
+			return true;
+
+		int slot;
+
+		if (! m_outputFree.pop(slot))
+			return false;
+
+		m_interleave(buffer, dropped, frames - dropped, m_output[slot].bytes);
+		m_output[slot].frames = frames - dropped;
+		m_outputFull.push(slot);
+
+		return true;
+	};
+
+	bool ok = true;
+
+	for (;;)
+	{
+		int slot;
+
+		if (! m_inputFull.pop(slot))
+		{
+			ok = false;
+			break;
+		}
+
+		const int frames = m_input[slot].frames;
+
+		// End of the stream, the reader is done
+		if (frames < 0)
+			break;
+
+		// Last block is shorter, keep the allocation
+		buffer.setSize(channels, frames, false, false, true);
+		m_deinterleave(m_input[slot].bytes, buffer, frames);
+		m_inputFree.push(slot);
+
+		processor->processBlock(buffer, midiMessages);
+
+		if (! send(frames))
+		{
+			ok = false;
+			break;
+		}
+	}
+
+	while (ok && flush > 0)
+	{
+		const int frames = juce::jmin(blockSize, flush);
+		flush -= frames;
+
+		buffer.setSize(channels, frames, false, false, true);
+		buffer.clear();
+
+		processor->processBlock(buffer, midiMessages);
+		ok = send(frames);
+	}
+
+	// End marker, the writer stops after it
+	int slot;
+
+	if (ok && m_outputFree.pop(slot))
+	{
+		m_output[slot].frames = -1;
+		m_outputFull.push(slot);
+	}
+
+	writer.join();
+
+	// Unblocks a reader still waiting for a free slot after a write error
+	closeQueues();
+	reader.join();
+
+	processor->releaseResources();
+
+	if (m_writeFailed)
+		error = "Write to stdout failed";
+	else if (m_readFailed)
+		error = "Read from stdin failed";
+
+	return error.isEmpty();
+}
+
+void StreamRenderer::runReader()
+{
+	const size_t blockBytes = (size_t)(m_options.blockSize * m_frameBytes);
+
+	for (;;)
+	{
+		int slot;
+
+		if (! m_inputFree.pop(slot))
+			return;
+
+		// Returns short only at the end of the stream or on an error, a trailing partial frame is dropped
+		auto& input = m_input[slot];
+		const size_t bytes = std::fread(input.bytes, 1, blockBytes, stdin);
+		input.frames = (int)(bytes / (size_t)m_frameBytes);
+
+		if (bytes == blockBytes)
+		{
+			m_inputFull.push(slot);
+			continue;
+		}
+
+		if (std::ferror(stdin))
+			m_readFailed = true;
+
+		if (input.frames > 0)
+		{
+			m_inputFull.push(slot);
+
+			if (! m_inputFree.pop(slot))
+				return;
+		}
+
+		m_input[slot].frames = -1;
+		m_inputFull.push(slot);
+		return;
+	}
+}
+
+void StreamRenderer::runWriter()
+{
+	for (;;)
+	{
+		int slot;
+
+		if (! m_outputFull.pop(slot))
+			return;
+
+		const auto& output = m_output[slot];
+
+		if (output.frames < 0)
+			return;
+
+		const size_t bytes = (size_t)(output.frames * m_frameBytes);
+
+		if (std::fwrite(output.bytes, 1, bytes, stdout) != bytes)
+		{
+			// Stops the processing loop and the reader
+			m_writeFailed = true;
+			closeQueues();
+			return;
+		}
+
+		m_outputFree.push(slot);
+	}
+}
+
+void StreamRenderer::closeQueues()
+{
+	m_inputFree.close();
+	m_inputFull.close();
+	m_outputFree.close();
+	m_outputFull.close();
+}
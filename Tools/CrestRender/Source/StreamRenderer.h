@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    StreamRenderer.h
+
+    Runs CrestCompressorAudioProcessor as a pipe filter: interleaved raw PCM
+    in on stdin, same format out on stdout.
+
+    Reading, processing and writing run on three threads that hand fixed
+    blocks over through two slots per direction, so a block is read while
+    the previous one is processed and the one before is written. At most
+    four blocks are in flight plus the lookahead, which is removed from the
+    output so it lines up with the input sample for sample. Every buffer is
+    allocated before the first block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Common/ProcessorSettings.h"
+
+#include <condition_variable>
+#include <mutex>
+
+//==============================================================================
+class StreamRenderer
+{
+public:
+	enum class SampleFormat
+	{
+		Float32,    // IEEE float, native byte order
+		Int16,      // Little endian
+		Int24       // Little endian, packed 3 bytes
+	};
+
+	struct Options
+	{
+		ProcessorSettings::Values parameters;
+		SampleFormat format = SampleFormat::Float32;
+		double sampleRate = 48000.0;
+		int channels = 2;
+		int blockSize = 512;
+	};
+
+	explicit StreamRenderer(const Options& options);
+
+	// Until stdin is closed, false on a read, write or parameter error
+	bool run(juce::String& error);
+
+	// "f32", "s16", "s24"
+	static bool parseFormat(const juce::String& text, SampleFormat& format);
+
+private:
+	static const int SLOTS = 2;
+
+	// Interleaved bytes of one block
+	struct Slot
+	{
+		juce::HeapBlock<char> bytes;
+		int frames = 0;    // Negative marks the end of the stream
+	};
+
+	// Slot indices handed from one thread to the next, fixed capacity, no allocation
+	class SlotQueue
+	{
+	public:
+		void push(int slot);
+
+		// False once closed
+		bool pop(int& slot);
+		void close();
+
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		int m_slots[SLOTS] = {};
+		int m_count = 0;
+		int m_read = 0;
+		bool m_closed = false;
+	};
+
+	using Deinterleave = void (*)(const char* source, juce::AudioBuffer<float>& buffer, int frames);
+	using Interleave = void (*)(const juce::AudioBuffer<float>& buffer, int start, int frames, char* dest);
+
+	void runReader();
+	void runWriter();
+	void closeQueues();
+
+	Options m_options;
+	int m_frameBytes = 0;
+
+	Deinterleave m_deinterleave = nullptr;
+	Interleave m_interleave = nullptr;
+
+	Slot m_input[SLOTS];
+	Slot m_output[SLOTS];
+
+	SlotQueue m_inputFree;
+	SlotQueue m_inputFull;
+	SlotQueue m_outputFree;
+	SlotQueue m_outputFull;
+
+	std::atomic<bool> m_readFailed{ false };
+	std::atomic<bool> m_writeFailed{ false };
+
+	JUCE_DECLARE_NON_COPYABLE(StreamRenderer)
+};